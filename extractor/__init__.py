@@ -25,6 +25,13 @@ __homepage__ = 'https://github.com/mutalyzer/description-extractor'
 
 
 describe_dna = describe.describe_dna
+describe_dna_allele = describe.describe_dna_allele
 describe_protein = describe.describe_protein
+describe_protein_batch = describe.describe_protein_batch
 describe_repeats = describe.describe_repeats
+describe_translation = describe.describe_translation
 extract = extractor.extract
+extract_async = describe.extract_async
+extract_batch = extractor.extract_batch
+extract_translated = extractor.extract_translated
+short_tandem_repeats = extractor.short_tandem_repeats
@@ -23,6 +23,10 @@ using namespace mutalyzer;
 using namespace std;
 
 
+// The standard codon table (NCBI translation table 1).
+static char_t const* const CODON_STRING = "KNKNTTTTRSRSIIMIQHQHPPPPRRRRLLLLEDEDAAAAGGGGVVVV*Y*YSSSS*CWCLFLF";
+
+
 // Entry point.
 int main(int argc, char* argv[])
 {
@@ -91,7 +95,7 @@ int main(int argc, char* argv[])
         continue;
       } // if
       vector<Variant> variants;
-      extract(variants, protein[i].c_str(), protein[i].length(), protein[j].c_str(), protein[j].length(), TYPE_PROTEIN, "KNKNTTTTRSRSIIMIQHQHPPPPRRRRLLLLEDEDAAAAGGGGVVVV*Y*YSSSS*CWCLFLF");
+      extract(variants, protein[i].c_str(), protein[i].length(), protein[j].c_str(), protein[j].length(), TYPE_PROTEIN, CODON_STRING);
 
       size_t best = 0;
       for (std::vector<Variant>::iterator it = variants.begin(); it != variants.end(); ++it)
@@ -120,9 +124,9 @@ int main(int argc, char* argv[])
     if (it->type >= FRAME_SHIFT)
     {
       fprintf(stdout, "%ld--%ld, %ld--%ld, %d, %lf, %ld--%ld\n", it->reference_start, it->reference_end, it->sample_start, it->sample_end, it->type, 1.f - it->probability, it->transposition_start, it->transposition_end);
-      char_t ref_DNA[(it->reference_end - it->reference_start) * 3];
-      char_t alt_DNA[(it->reference_end - it->reference_start) * 3];
-      backtranslation(ref_DNA, alt_DNA, reference, it->reference_start, sample, it->sample_start, it->reference_end - it->reference_start, it->type);
+      char_t* const ref_DNA = new char_t[(it->reference_end - it->reference_start) * 3];
+      char_t* const alt_DNA = new char_t[(it->reference_end - it->reference_start) * 3];
+      backtranslation(ref_DNA, alt_DNA, reference, it->reference_start, sample, it->sample_start, it->reference_end - it->reference_start, it->type, *get_backtranslation_table(CODON_STRING));
       fprintf(stdout, "ref_DNA: ");
       fwrite(ref_DNA, sizeof(char_t), (it->reference_end - it->reference_start) * 3, stdout);
       fprintf(stdout, "\nref_pro: ");
@@ -132,6 +136,8 @@ int main(int argc, char* argv[])
       fprintf(stdout, "\nalt_pro: ");
       fwrite(sample + it->sample_start, sizeof(char_t), (it->reference_end - it->reference_start), stdout);
       fprintf(stdout , "\n");
+      delete[] ref_DNA;
+      delete[] alt_DNA;
     } // if
     else
     {
@@ -8,6 +8,9 @@ from __future__ import (absolute_import, division, print_function,
     unicode_literals)
 
 import math
+import os
+import threading
+import weakref
 
 from Bio.Seq import reverse_complement
 
@@ -114,8 +117,8 @@ def var_to_dna_var(s1, s2, var, seq_list=[], weight_position=1):
     # Insertion / Duplication.
     if var.reference_start == var.reference_end:
         ins_length = var.sample_end - var.sample_start
-        shift5, shift3 = roll(s2, var.sample_start + 1, var.sample_end)
-        shift = shift5 + shift3
+        shift3 = var.shift3
+        shift = var.shift5 + shift3
 
         var.reference_start += shift3
         var.reference_end += shift3
@@ -151,8 +154,8 @@ def var_to_dna_var(s1, s2, var, seq_list=[], weight_position=1):
 
     # Deletion.
     if var.sample_start == var.sample_end:
-        shift5, shift3 = roll(s1, var.reference_start + 1, var.reference_end)
-        shift = shift5 + shift3
+        shift3 = var.shift3
+        shift = var.shift5 + shift3
 
         var.reference_start += shift3
         var.reference_end += shift3
@@ -179,7 +182,7 @@ def var_to_dna_var(s1, s2, var, seq_list=[], weight_position=1):
 
     # Inversion.
     if var.type & extractor.REVERSE_COMPLEMENT:
-        trim = palinsnoop(s1[var.reference_start:var.reference_end])
+        trim = var.palindrome
 
         if trim > 0: # Partial palindrome.
             var.reference_end -= trim
@@ -225,8 +228,8 @@ def var_to_protein_var(s1, s2, var, seq_list=[], weight_position=1):
     # Insertion / Duplication.
     if var.reference_start == var.reference_end:
         ins_length = var.sample_end - var.sample_start
-        shift5, shift3 = roll(s2, var.sample_start + 1, var.sample_end)
-        shift = shift5 + shift3
+        shift3 = var.shift3
+        shift = var.shift5 + shift3
 
         var.reference_start += shift3
         var.reference_end += shift3
@@ -257,8 +260,8 @@ def var_to_protein_var(s1, s2, var, seq_list=[], weight_position=1):
 
     # Deletion.
     if var.sample_start == var.sample_end:
-        shift5, shift3 = roll(s1, var.reference_start + 1, var.reference_end)
-        shift = shift5 + shift3
+        shift3 = var.shift3
+        shift = var.shift5 + shift3
 
         var.reference_start += shift3
         var.reference_end += shift3
@@ -312,7 +315,7 @@ def describe_dna(s1, s2):
     extracted = extractor.extract(s1_swig[0], s1_swig[1],
                                   s2_swig[0], s2_swig[1], extractor.TYPE_DNA)
 
-    for variant in extracted.variants:
+    for variant in util.variant_records(extracted):
 
         if variant.type & extractor.TRANSPOSITION_OPEN:
             if not in_transposition:
@@ -348,21 +351,42 @@ def describe_dna(s1, s2):
     return description
 
 
+def describe_dna_allele(s1, s2):
+    """
+    Give the HGVS allele description of the change from {s1} to {s2} as a
+    string. The description is formatted by the extractor module, so no
+    intermediate objects are constructed.
+
+    :arg unicode s1: Sequence 1.
+    :arg unicode s2: Sequence 2.
+
+    :returns unicode: The HGVS allele description, e.g., [3dup;8G>T].
+    """
+    s1_swig = util.swig_str(s1)
+    s2_swig = util.swig_str(s2)
+    extracted = extractor.extract(s1_swig[0], s1_swig[1],
+                                  s2_swig[0], s2_swig[1], extractor.TYPE_DNA)
+
+    return extractor.describe_dna_allele(s1_swig[0], s1_swig[1],
+        s2_swig[0], s2_swig[1], extracted.variants)
+
+
 
 def mask_string(string, units):
-    MASK = '$'
-    repeats = []
-    for unit in units:
-        found = string.find(unit)
-        while found != -1:
-            last = len(repeats) - 1
-            if last > -1 and repeats[last]['start'] + repeats[last]['count'] * len(unit) == found:
-                repeats[last]['count'] += 1
-            else:
-                repeats.append({'start': found, 'count': 1, 'unit': unit})
-            string = string[:found] + MASK * len(unit) + string[found + len(unit):]
-            found = string.find(unit, found + len(unit))
-    return string, sorted(repeats, key=lambda repeat: repeat['start'])
+    """
+    Mask all occurrences of the repeat units (in order) in a string. The
+    masking is done by the extractor module in one pass over the string.
+
+    :arg unicode string: String to be masked.
+    :arg list(unicode) units: Repeat units.
+
+    :returns: The masked string and its repeats ordered by position.
+    """
+    string_swig = util.swig_str(string)
+    masked = extractor.mask_repeats(string_swig[0], string_swig[1],
+        extractor.StringVector([util.swig_str(unit)[0] for unit in units]))
+    return masked.string, [{'start': repeat.start, 'count': repeat.count,
+        'unit': units[repeat.unit]} for repeat in masked.repeats]
 
 def describe_repeats(reference, sample, units):
     MASK = '$'
@@ -385,41 +409,8 @@ def describe_repeats(reference, sample, units):
     extracted = extractor.extract(ref_swig[0], ref_swig[1],
                                   alt_swig[0], alt_swig[1], extractor.TYPE_DNA)
 
-    variant_list = []
-    for variant in extracted.variants:
-        replaced = []
-        i = variant.sample_start
-        start = i
-        while i < variant.sample_end:
-            while i < variant.sample_end and masked_alt[i + sample_start] != MASK:
-                i += 1
-            if i < variant.sample_end:
-                split = extractor.Variant()
-                split.reference_start = variant.reference_start + reference_start
-                split.reference_end = variant.reference_end + reference_start
-                split.sample_start = start
-                split.sample_end = i
-                split.type = variant.type
-                split.transposition_start = variant.transposition_start + reference_start
-                split.transposition_end = variant.transposition_end + reference_start
-                replaced.append(split)
-                while i < variant.sample_end and masked_alt[i + sample_start] == MASK:
-                    i += 1
-                start = i
-
-        if len(replaced) > 0:
-            split = extractor.Variant()
-            split.reference_start = variant.reference_start + reference_start
-            split.reference_end = variant.reference_end + reference_start
-            split.sample_start = start
-            split.sample_end = variant.sample_end
-            split.type = variant.type
-            split.transposition_start = variant.transposition_start + reference_start
-            split.transposition_end = variant.transposition_end + reference_start
-            replaced.append(split)
-            variant_list += replaced
-        else:
-            variant_list.append(variant)
+    variant_list = extractor.split_masked_variants(alt_swig[0], alt_swig[1],
+        extracted.variants, reference_start)
 
     in_transposition = 0
     index = 0
@@ -510,59 +501,197 @@ def describe_protein(s1, s2, codon_table=1):
     """
     codons = util.codon_table_string(codon_table)
 
-    description = ProteinAllele()
-
     s1_swig = util.swig_str(s1)
     s2_swig = util.swig_str(s2)
     codons_swig = util.swig_str(codons)
 
     extracted = extractor.extract(s1_swig[0], s1_swig[1],
         s2_swig[0], s2_swig[1], extractor.TYPE_PROTEIN, codons_swig[0])
-    variants = extracted.variants
 
-    #for variant in variants:
-    #    print_var(variant)
-    #print()
+    return protein_description(s1, s2, extracted)
 
-    index = 0
-    while index < len(variants):
-        if variants[index].type != extractor.IDENTITY:
-            variant = variants[index]
-            index += 1
-            seq_list = AISeqList()
 
-            # NOTE: This is for filling.
-            last_end = variants[index].reference_start
+def describe_translation(s1, s2, codon_table=1):
+    """
+    Give the protein description of two coding DNA sequences. Both
+    sequences are translated and extracted by the extractor, so the
+    protein sequences are only constructed once.
 
-            while (index < len(variants) and
-                    variants[index].type & extractor.FRAME_SHIFT):
+    :arg s1: Reference coding DNA sequence.
+    :arg s2: Sample coding DNA sequence.
+    :arg codon_table: ID of a codon table.
 
-                if last_end < variants[index].sample_start:
-                    seq_list.append(AISeq(
-                        s2[last_end:variants[index].sample_start]))
+    :returns: Protein description.
+    """
+    codons = util.codon_table_string(codon_table)
 
-                last_end = variants[index].sample_end
+    s1_swig = util.swig_str(s1)
+    s2_swig = util.swig_str(s2)
+    codons_swig = util.swig_str(codons)
 
-                seq_list.append(AISeq(
-                    s2[variants[index].sample_start:
-                        variants[index].sample_end],
-                    start=variants[index].reference_start + 1,
-                    end=variants[index].reference_end,
-                    sample_start=variants[index].sample_start + 1,
-                    sample_end=variants[index].sample_end,
-                    frames=get_frames(variants[index].type)))
-
-                # NOTE: Perhaps use trans_open, trans_close to ...
-                index += 1
-
-            if last_end < variant.sample_end:
-                seq_list.append(AISeq(s2[last_end:variant.sample_end]))
-
-            var = var_to_protein_var(s1, s2, variant, seq_list,
-                weight_position=extracted.weight_position)
-            description.append(var)
+    extracted = extractor.extract_translated(s1_swig[0], s1_swig[1],
+        s2_swig[0], s2_swig[1], codons_swig[0])
+
+    return protein_description(extracted.reference, extracted.sample,
+        extracted)
+
+
+#: Pending asynchronous extractions (see `extract_async`): the event loop
+#: and future per extraction identifier.
+_async_futures = {}
+
+#: Event loops watching the extraction file descriptor.
+_async_loops = weakref.WeakSet()
+
+#: Guards the registration of a future against the completion of its
+#: extraction (reported to the event loop of any thread).
+_async_lock = threading.Lock()
+
+
+def _reset_async():
+    """
+    Forget the pending asynchronous extractions in a forked child: the
+    extractor module starts a new worker pool there.
+    """
+    global _async_lock
+
+    _async_futures.clear()
+    _async_loops.clear()
+    _async_lock = threading.Lock()
+
+
+if hasattr(os, 'register_at_fork'):
+    os.register_at_fork(after_in_child=_reset_async)
+
+
+def _set_result(future, result):
+    if not future.done():
+        future.set_result(result)
+
+
+def _set_exception(future, exception):
+    if not future.done():
+        future.set_exception(exception)
+
+
+def _complete_extractions():
+    """
+    Resolve the futures of the completed asynchronous extractions. Called by
+    an event loop when the extraction file descriptor is readable. The
+    results of extractions not queued by `extract_async` are left for their
+    owner.
+    """
+    completed = []
+    with _async_lock:
+        for identifier in extractor.completed_extractions():
+            pending = _async_futures.pop(identifier, None)
+            if pending is not None:
+                completed.append((identifier,) + pending)
+
+    for identifier, loop, future in completed:
+        try:
+            result = extractor.extraction_result(identifier)
+        except Exception as exception:
+            loop.call_soon_threadsafe(_set_exception, future, exception)
         else:
-            index += 1
+            loop.call_soon_threadsafe(_set_result, future, result)
+
+
+def extract_async(s1, s2, type=extractor.TYPE_DNA, codon_table=1,
+        annotate=True, loop=None):
+    """
+    Extract the variants between {s1} and {s2} on the worker threads of the
+    extractor module. Completion is signalled to the event loop through a
+    file descriptor, so no Python thread is used per extraction. Must be
+    called from the thread running the event loop (Python 3 only).
+
+    :arg s1: Reference sequence.
+    :arg s2: Sample sequence.
+    :arg type: Type of the sequences (see `extractor.extract`).
+    :arg codon_table: ID of a codon table (protein extraction only).
+    :arg annotate: Calculate the frame shift annotation (protein
+        extraction only).
+    :arg loop: Event loop (default: the current event loop).
+
+    :returns: An asyncio future of the extracted variant list.
+    """
+    import asyncio
+
+    if loop is None:
+        loop = asyncio.get_event_loop()
+    if loop not in _async_loops:
+        loop.add_reader(extractor.extraction_fd(), _complete_extractions)
+        _async_loops.add(loop)
+
+    s1_swig = util.swig_str(s1)
+    s2_swig = util.swig_str(s2)
+    codons = None
+    if type == extractor.TYPE_PROTEIN:
+        codons = util.swig_str(util.codon_table_string(codon_table))[0]
+
+    # The future is registered before the completion can be reported.
+    future = loop.create_future()
+    with _async_lock:
+        identifier = extractor.extract_async(s1_swig[0], s1_swig[1],
+            s2_swig[0], s2_swig[1], type, codons, annotate)
+        _async_futures[identifier] = (loop, future)
+    return future
+
+
+def describe_protein_batch(pairs, codon_table=1, threads=0):
+    """
+    Describe a batch of protein pairs (e.g., all isoforms of a gene or all
+    proteins of a proteome) in one call to the extractor. The pairs are
+    extracted in parallel, sharing one prepared codon table.
+
+    :arg pairs: List of (reference, sample) protein pairs.
+    :arg codon_table: ID of a codon table.
+    :arg threads: Number of threads (0 for the number of cores).
+
+    :returns: List of descriptions (in order of the pairs).
+    """
+    codons = util.codon_table_string(codon_table)
+
+    references = extractor.StringVector(
+        [util.swig_str(s1)[0] for s1, _ in pairs])
+    samples = extractor.StringVector(
+        [util.swig_str(s2)[0] for _, s2 in pairs])
+    codons_swig = util.swig_str(codons)
+
+    extracted = extractor.extract_batch(references, samples,
+        extractor.TYPE_PROTEIN, codons_swig[0], threads)
+
+    return [protein_description(s1, s2, extracted_pair)
+            for (s1, s2), extracted_pair in zip(pairs, extracted)]
+
+
+def protein_description(s1, s2, extracted):
+    """
+    Construct the protein description from the extracted variants. The
+    variants are grouped with their frame shift annotations by the
+    extractor module.
+    """
+    description = ProteinAllele()
+
+    for protein_variant in extractor.group_protein_variants(
+            extracted.variants):
+        seq_list = AISeqList()
+        for segment in protein_variant.segments:
+            if segment.frames:
+                seq_list.append(AISeq(
+                    s2[segment.sample_start:segment.sample_end],
+                    start=segment.reference_start + 1,
+                    end=segment.reference_end,
+                    sample_start=segment.sample_start + 1,
+                    sample_end=segment.sample_end,
+                    frames=list(segment.frames)))
+            else:
+                seq_list.append(AISeq(
+                    s2[segment.sample_start:segment.sample_end]))
+
+        var = var_to_protein_var(s1, s2, protein_variant.variant, seq_list,
+            weight_position=extracted.weight_position)
+        description.append(var)
 
     if not description:
         return ProteinAllele([ProteinVar()])
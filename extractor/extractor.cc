@@ -12,17 +12,40 @@
 
 #include "extractor.h"
 
+#if __cplusplus < 201703L
+#error "The Extractor library requires C++17 (compile with -std=c++17)."
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+
 namespace mutalyzer
 {
 
 // The (average) description length of a position. Depends on the
-// reference string length: ceil(log10(|reference| / 4)).
-size_t weight_position = 1;
+// reference string length: ceil(log10(|reference| / 4)). Every thread
+// has its own extraction run.
+thread_local size_t weight_position = 1;
 
 // This global variable is a dirty trick used to always have access to
 // the complete reference strings even when deep into the recursion.
 // This seems necessary to compute transpositions.
-size_t global_reference_length = 0;
+thread_local size_t global_reference_length = 0;
 
 static char_t const IUPAC_ALPHA[16] =
 {
@@ -52,48 +75,248 @@ static char_t const IUPAC_BASE[4] =
   'T'
 }; // IUPAC_BASE
 
-// The actual frame shift map indexed on the lower 127 ASCII
-// characters. This map should be precalculated given a codon string
-// by the initialize_frame_shift_map function.
-static uint8_t frame_shift_map[128][128][128] = {{{FRAME_SHIFT_NONE}}};
-
-// A frequency count of all possible frame shifts (5) for all
-// combinations of two amino acids (indexed by the lower 127 ASCII
-// characters). Used to calculate the frame shift probability.
-static uint8_t frame_shift_count[128][128][5] = {{{0}}};
-
-static uint64_t acid_map[128] = {0x0ull};
+// The prepared codon tables (one per codon string). Entries are
+// never modified nor removed once published, so the list can be
+// traversed without locking. Only adding an entry is serialized.
+struct Codon_Table_Entry
+{
+  char_t                   codon_string[64];
+  Codon_Table              codon_table;
+  Codon_Table_Entry const* next;
+}; // Codon_Table_Entry
+
+static std::atomic<Codon_Table_Entry const*> codon_table_cache(0);
+static std::mutex                            codon_table_mutex;
+
+// The backtranslation tables (one per codon string) are kept apart
+// from the codon tables: they are large and only calculated on first
+// use. They are cached in the same way as the codon tables.
+struct Backtranslation_Table_Entry
+{
+  char_t                             codon_string[64];
+  Backtranslation_Table              backtranslation_table;
+  Backtranslation_Table_Entry const* next;
+}; // Backtranslation_Table_Entry
 
-static double acid_frequency[128] = {.0f};
-static double frame_shift_frequency[128][128][5] = {{{.0f}}};
+static std::atomic<Backtranslation_Table_Entry const*> backtranslation_table_cache(0);
+static std::mutex                                      backtranslation_table_mutex;
 
 // This character is always ignored when LCS matching and can be used for
 // repeat masking
 static char_t const MASK = '$';
 
+// The extraction policies. The recursive extractor functions and
+// their kernels are instantiated for strings with or without a
+// complement string (COMPLEMENT, i.e., DNA/RNA) and for strings that
+// can contain the MASK character or not (MASKED). This removes these
+// checks from the inner loops. The extract function selects the
+// instantiation once per extraction run; the functions declared in
+// the header use the masked instantiations.
+template <bool MASKED>
+static inline bool unmasked(char_t const character)
+{
+  return !MASKED || character != MASK;
+} // unmasked
+
+template <bool COMPLEMENT, bool MASKED>
+static size_t extractor(std::vector<Variant> &variant,
+                        char_t const* const   reference,
+                        char_t const* const   complement,
+                        size_t           reference_start,
+                        size_t           reference_end,
+                        char_t const* const   sample,
+                        size_t           sample_start,
+                        size_t           sample_end);
+
+template <bool COMPLEMENT, bool MASKED>
+static size_t extractor_transposition(std::vector<Variant> &variant,
+                                      char_t const* const   reference,
+                                      char_t const* const   complement,
+                                      size_t const          reference_start,
+                                      size_t const          reference_end,
+                                      char_t const* const   sample,
+                                      size_t const          sample_start,
+                                      size_t const          sample_end,
+                                      size_t const          weight_trivial);
+
+template <bool COMPLEMENT, bool MASKED>
+static size_t LCS(std::vector<Substring> &substring,
+                  char_t const* const     reference,
+                  char_t const* const     complement,
+                  size_t const            reference_start,
+                  size_t const            reference_end,
+                  char_t const* const     sample,
+                  size_t const            sample_start,
+                  size_t const            sample_end,
+                  size_t const            cut_off);
+
+template <bool COMPLEMENT, bool MASKED>
+static size_t LCS_1(std::vector<Substring> &substring,
+                    char_t const* const     reference,
+                    char_t const* const     complement,
+                    size_t const            reference_start,
+                    size_t const            reference_end,
+                    char_t const* const     sample,
+                    size_t const            sample_start,
+                    size_t const            sample_end);
+
+template <bool COMPLEMENT, bool MASKED>
+static size_t LCS_k(std::vector<Substring> &substring,
+                    char_t const* const     reference,
+                    char_t const* const     complement,
+                    size_t const            reference_start,
+                    size_t const            reference_end,
+                    char_t const* const     sample,
+                    size_t const            sample_start,
+                    size_t const            sample_end,
+                    size_t const            k);
+
+template <bool MASKED>
+static size_t extractor_protein(std::vector<Variant> &variant,
+                                char_t const* const   reference,
+                                size_t const          reference_start,
+                                size_t const          reference_end,
+                                char_t const* const   sample,
+                                size_t const          sample_start,
+                                size_t const          sample_end);
+
+template <bool MASKED>
+static bool string_match(char_t const* const string_1,
+                         char_t const* const string_2,
+                         size_t const        length);
+
+template <bool MASKED>
+static bool string_match_reverse(char_t const* const string_1,
+                                 char_t const* const string_2,
+                                 size_t const        length);
+
+template <bool MASKED>
+static size_t prefix_match(char_t const* const reference,
+                           size_t const        reference_length,
+                           char_t const* const sample,
+                           size_t const        sample_length);
+
+template <bool MASKED>
+static size_t suffix_match(char_t const* const reference,
+                           size_t const        reference_length,
+                           char_t const* const sample,
+                           size_t const        sample_length,
+                           size_t const        prefix);
+
+// Runs the tasks 0, ..., tasks - 1 on a number of threads (the calling
+// thread included; 0 --- number of cores). Every thread takes the next
+// unprocessed task. An exception (in a task or while starting a thread)
+// stops the remaining tasks; it is rethrown once all threads are joined.
+template <typename function_t>
+static void parallel_for(size_t const      tasks,
+                         size_t const      threads,
+                         function_t const& task)
+{
+  size_t workers = threads > 0 ? threads : std::thread::hardware_concurrency();
+  if (workers > tasks)
+  {
+    workers = tasks;
+  } // if
+  if (workers == 0)
+  {
+    workers = 1;
+  } // if
+
+  std::atomic<size_t> next(0);
+  std::vector<std::exception_ptr> failure(workers);
+  auto worker = [&](size_t const k)
+  {
+    try
+    {
+      for (size_t i = next++; i < tasks; i = next++)
+      {
+        task(i);
+      } // for
+    } // try
+    catch (...)
+    {
+      failure[k] = std::current_exception();
+      next = tasks;
+    } // catch
+  };
+
+  std::vector<std::thread> pool;
+  pool.reserve(workers - 1);
+  for (size_t k = 1; k < workers; ++k)
+  {
+    try
+    {
+      pool.push_back(std::thread(worker, k));
+    } // try
+    catch (...)
+    {
+      failure[k] = std::current_exception();
+      next = tasks;
+      break;
+    } // catch
+  } // for
+  worker(0);
+  for (std::vector<std::thread>::iterator it = pool.begin(); it != pool.end(); ++it)
+  {
+    it->join();
+  } // for
+
+  for (std::vector<std::exception_ptr>::const_iterator it = failure.begin(); it != failure.end(); ++it)
+  {
+    if (*it)
+    {
+      std::rethrow_exception(*it);
+    } // if
+  } // for
+  return;
+} // parallel_for
+
 // Only used to interface to Python: calls the C++ extract function.
 Variant_List extract(char_t const* const reference,
                      size_t const        reference_length,
                      char_t const* const sample,
                      size_t const        sample_length,
                      int const           type,
-                     char_t const* const codon_string)
+                     char_t const* const codon_string,
+                     bool const          annotate,
+                     size_t const        annotation_threads)
 {
   Variant_List variant_list;
-  extract(variant_list.variants, reference, reference_length, sample, sample_length, type, codon_string);
+  extract(variant_list.variants, reference, reference_length, sample, sample_length, type, codon_string, annotate, annotation_threads);
   variant_list.weight_position = weight_position;
   return variant_list;
 } // extract
 
-// The main library function. Extract all variants (regions of change)
-// from the given strings.
-size_t extract(std::vector<Variant> &variant,
-               char_t const* const   reference,
-               size_t const          reference_length,
-               char_t const* const   sample,
-               size_t const          sample_length,
-               int const             type,
-               char_t const* const   codon_string)
+// Calculates the frame shift annotation of a single substitution. The
+// log probability prefix sums are only calculated for the reference
+// range of the substitution. The substitutions extracted from protein
+// strings are always separated by (non-empty) identities, so their
+// ranges in the prefix sums do not overlap.
+static void annotate_frame_shift(std::vector<Variant> &annotation,
+                                 char_t const* const   reference,
+                                 size_t const          reference_length,
+                                 char_t const* const   sample,
+                                 Variant const&        variant,
+                                 Codon_Table const&    codon_table,
+                                 double* const         log_probability)
+{
+  frame_shift_log_probability(log_probability, reference, variant.reference_start, variant.reference_end, reference_length, codon_table);
+  extractor_frame_shift(annotation, reference, variant.reference_start, variant.reference_end, sample, variant.sample_start, variant.sample_end, codon_table, log_probability);
+  return;
+} // annotate_frame_shift
+
+// Extract all variants (regions of change) from the given strings
+// using an already prepared codon table (only for protein strings).
+// The frame shift annotation is optional and can be done in parallel.
+static size_t extract_variants(std::vector<Variant> &variant,
+                               char_t const* const   reference,
+                               size_t const          reference_length,
+                               char_t const* const   sample,
+                               size_t const          sample_length,
+                               int const             type,
+                               Codon_Table const*    codon_table,
+                               bool const            annotate,
+                               size_t const          annotation_threads)
 {
   // The global variables are set for this extraction run.
   global_reference_length = reference_length;
@@ -103,9 +326,14 @@ size_t extract(std::vector<Variant> &variant,
     weight_position = 1;
   } // if
 
+  // The extraction policy: only masked strings need to be checked for
+  // the MASK character.
+  bool const masked = std::find(reference, reference + reference_length, MASK) != reference + reference_length ||
+                      std::find(sample, sample + sample_length, MASK) != sample + sample_length;
+
   // Common prefix and suffix snooping.
-  size_t const prefix = prefix_match(reference, reference_length, sample, sample_length);
-  size_t const suffix = suffix_match(reference, reference_length, sample, sample_length, prefix);
+  size_t const prefix = masked ? prefix_match<true>(reference, reference_length, sample, sample_length) : prefix_match<false>(reference, reference_length, sample, sample_length);
+  size_t const suffix = masked ? suffix_match<true>(reference, reference_length, sample, sample_length, prefix) : suffix_match<false>(reference, reference_length, sample, sample_length, prefix);
 
 
 #if defined(__debug__)
@@ -130,7 +358,10 @@ size_t extract(std::vector<Variant> &variant,
 
   // Do NOT construct a complement string for protein strings. All
   // other string types default to protein strings.
+  // The complement string is owned (and cleaned up) by
+  // complement_owner, also when the extraction throws.
   char_t const* complement = type == TYPE_DNA ? IUPAC_complement(reference, reference_length) : 0;
+  std::unique_ptr<char_t const[]> const complement_owner(complement);
 
 
 #if defined(__debug__)
@@ -149,17 +380,23 @@ size_t extract(std::vector<Variant> &variant,
     variant.push_back(Variant(0, prefix, 0, prefix));
   } // if
 
-  // The actual extraction process starts here.
+  // The actual extraction process starts here (with the
+  // instantiation of the extraction policy).
   size_t weight;
   if (type == TYPE_PROTEIN)
   {
-    initialize_frame_shift_map(codon_string);
-
-    weight = extractor_protein(variant, reference, prefix, reference_length - suffix, sample, prefix, sample_length - suffix);
+    weight = masked ? extractor_protein<true>(variant, reference, prefix, reference_length - suffix, sample, prefix, sample_length - suffix)
+                    : extractor_protein<false>(variant, reference, prefix, reference_length - suffix, sample, prefix, sample_length - suffix);
+  } // if
+  else if (complement != 0)
+  {
+    weight = masked ? extractor<true, true>(variant, reference, complement, prefix, reference_length - suffix, sample, prefix, sample_length - suffix)
+                    : extractor<true, false>(variant, reference, complement, prefix, reference_length - suffix, sample, prefix, sample_length - suffix);
   } // if
   else
   {
-    weight = extractor(variant, reference, complement, prefix, reference_length - suffix, sample, prefix, sample_length - suffix);
+    weight = masked ? extractor<false, true>(variant, reference, complement, prefix, reference_length - suffix, sample, prefix, sample_length - suffix)
+                    : extractor<false, false>(variant, reference, complement, prefix, reference_length - suffix, sample, prefix, sample_length - suffix);
   } // else
 
   if (suffix > 0)
@@ -168,503 +405,1220 @@ size_t extract(std::vector<Variant> &variant,
   } // if
 
 
-  // Frame shift annotation starts here.
-  if (type == TYPE_PROTEIN)
+  // Frame shift annotation starts here. The substitutions are
+  // annotated independently (possibly in parallel) and the
+  // annotations are merged in place after their substitutions.
+  if (type == TYPE_PROTEIN && annotate)
   {
-    std::vector<Variant> merged;
-    for (std::vector<Variant>::iterator it = variant.begin(); it != variant.end(); ++it)
+    std::vector<size_t> substitution;
+    size_t work = 0;
+    for (size_t i = 0; i < variant.size(); ++i)
+    {
+      if (variant[i].type == SUBSTITUTION)
+      {
+        substitution.push_back(i);
+        work += (variant[i].reference_end - variant[i].reference_start) * (variant[i].sample_end - variant[i].sample_start);
+      } // if
+    } // for
+
+    std::vector<std::vector<Variant> > annotation(substitution.size());
+    std::vector<double> log_probability(5 * (reference_length + 1));
+    parallel_for(substitution.size(), work < FRAME_SHIFT_PARALLEL_THRESHOLD ? 1 : annotation_threads, [&](size_t const i)
+    {
+      annotate_frame_shift(annotation[i], reference, reference_length, sample, variant[substitution[i]], *codon_table, log_probability.data());
+    });
+
+    size_t size = variant.size();
+    for (size_t i = 0; i < annotation.size(); ++i)
+    {
+      size += annotation[i].size();
+    } // for
+    size_t k = annotation.size();
+    size_t j = variant.size();
+    variant.resize(size);
+    for (size_t i = size; j > 0; )
     {
-      merged.push_back(*it);
-      if (it->type == SUBSTITUTION)
+      --j;
+      if (k > 0 && substitution[k - 1] == j)
       {
-        std::vector<Variant> annotation;
-        extractor_frame_shift(annotation, reference, it->reference_start, it->reference_end, sample, it->sample_start, it->sample_end);
-        merged.insert(merged.end(), annotation.begin(), annotation.end());
+        --k;
+        for (std::vector<Variant>::reverse_iterator it = annotation[k].rbegin(); it != annotation[k].rend(); ++it)
+        {
+          variant[--i] = *it;
+        } // for
       } // if
+      variant[--i] = variant[j];
     } // for
-    variant = merged;
   } // if
 
 
-  // Do NOT forget to clean up the complement string.
-  delete[] complement;
+  // The variability of insertions (within the sample string) and
+  // deletions (within the reference string) and the palindromic
+  // prefix of inversions are calculated here, such that the
+  // description does not need to scan the strings again.
+  for (std::vector<Variant>::iterator it = variant.begin(); it != variant.end(); ++it)
+  {
+    if (it->reference_start == it->reference_end)
+    {
+      roll(it->shift5, it->shift3, sample, sample_length, it->sample_start, it->sample_end);
+    } // if
+    else if (it->sample_start == it->sample_end)
+    {
+      roll(it->shift5, it->shift3, reference, reference_length, it->reference_start, it->reference_end);
+    } // if
+    else if (type == TYPE_DNA && (it->type & REVERSE_COMPLEMENT))
+    {
+      it->palindrome = palindrome_prefix(reference, it->reference_start, it->reference_end);
+    } // if
+  } // for
 
   return weight;
-} // extract
+} // extract_variants
 
-// This is the recursive extractor function. It works as follows:
-// First, determine the ``best fitting'' longest common substring
-// (LCS) (possibly as a reverse complement) and discard it from the
-// solution. Then apply the same function on the remaining prefixes
-// and suffixes. If there is no LCS it is a variant (region of
-// change), i.e., a deletion/insertion.
-// With regard to the reverse complement: the complement string is, as
-// its name suggests, just the complement (DNA/RNA) of the reference
-// string but it is NOT reversed.
-size_t extractor(std::vector<Variant> &variant,
-                 char_t const* const   reference,
-                 char_t const* const   complement,
-                 size_t           reference_start,
-                 size_t           reference_end,
-                 char_t const* const   sample,
-                 size_t           sample_start,
-                 size_t           sample_end)
+// The main library function. Extract all variants (regions of change)
+// from the given strings.
+size_t extract(std::vector<Variant> &variant,
+               char_t const* const   reference,
+               size_t const          reference_length,
+               char_t const* const   sample,
+               size_t const          sample_length,
+               int const             type,
+               char_t const* const   codon_string,
+               bool const            annotate,
+               size_t const          annotation_threads)
 {
-  // First do prefix and suffix matching on the MASK character
-  size_t i = 0;
-  while (reference_start + i < reference_end && reference[reference_start + i] == MASK)
-  {
-    ++i;
-  } // while
-  reference_start += i;
-  i = 0;
-  while (reference_end - i - 1 > reference_start && reference[reference_end - i - 1] == MASK)
-  {
-    ++i;
-  } // while
-  reference_end -= i;
+  return extract_variants(variant, reference, reference_length, sample, sample_length, type, type == TYPE_PROTEIN ? get_codon_table(codon_string) : 0, annotate, annotation_threads);
+} // extract
 
-  i = 0;
-  while (sample_start + i < sample_end && sample[sample_start + i] == MASK)
-  {
-    ++i;
-  } // while
-  sample_start += i;
-  i = 0;
-  while (sample_end - i - 1 > sample_start && sample[sample_end - i - 1] == MASK)
+// Only used to interface to Python: the frame shift annotation of a
+// single substitution (on demand).
+std::vector<Variant> annotate_frame_shift(char_t const* const reference,
+                                          size_t const        reference_length,
+                                          char_t const* const sample,
+                                          size_t const        sample_length,
+                                          Variant const&      variant,
+                                          char_t const* const codon_string)
+{
+  std::vector<Variant> annotation;
+  if (variant.type != SUBSTITUTION ||
+      variant.reference_start > variant.reference_end || variant.reference_end > reference_length ||
+      variant.sample_start > variant.sample_end || variant.sample_end > sample_length)
   {
-    ++i;
-  } // while
-  sample_end -= i;
-
-
-  size_t const reference_length = reference_end - reference_start;
-  size_t const sample_length = sample_end - sample_start;
-
-  // Assume this is a deletion/insertion.
-  size_t const weight_trivial = weight_position + WEIGHT_DELETION_INSERTION + WEIGHT_BASE * sample_length + (reference_length != 1 ? weight_position + WEIGHT_SEPARATOR : 0);
-  size_t weight = 0;
-
+    return annotation;
+  } // if
 
-#if defined(__debug__)
-  fputs("Extraction\n", stderr);
-  fprintf(stderr, "  reference %ld--%ld:  ", reference_start, reference_end);
-  Dprint_truncated(reference, reference_start, reference_end);
-  fprintf(stderr, " (%ld)\n", reference_length);
-  fprintf(stderr, "  complement %ld--%ld: ", reference_start, reference_end);
-  Dprint_truncated(complement, reference_start, reference_end);
-  fprintf(stderr, " (%ld)\n", reference_length);
-  fprintf(stderr, "  sample %ld--%ld:     ", sample_start, sample_end);
-  Dprint_truncated(sample, sample_start, sample_end);
-  fprintf(stderr, " (%ld)\n", sample_length);
-  fprintf(stderr, "  trivial weight: %ld\n", weight_trivial);
-#endif
+  std::vector<double> log_probability(5 * (reference_length + 1));
+  annotate_frame_shift(annotation, reference, reference_length, sample, variant, *get_codon_table(codon_string), log_probability.data());
+  return annotation;
+} // annotate_frame_shift
+
+// Only used to interface to Python: translates both coding DNA
+// strings and extracts the protein strings.
+Translated_Variant_List extract_translated(char_t const* const reference,
+                                           size_t const        reference_length,
+                                           char_t const* const sample,
+                                           size_t const        sample_length,
+                                           char_t const* const codon_string,
+                                           bool const          annotate,
+                                           size_t const        annotation_threads)
+{
+  Translated_Variant_List variant_list;
+  variant_list.reference.resize(reference_length / 3);
+  variant_list.sample.resize(sample_length / 3);
+  translate(&variant_list.reference[0], reference, 0, reference_length, codon_string);
+  translate(&variant_list.sample[0], sample, 0, sample_length, codon_string);
 
+  extract_variants(variant_list.variants, variant_list.reference.data(), variant_list.reference.size(), variant_list.sample.data(), variant_list.sample.size(), TYPE_PROTEIN, get_codon_table(codon_string), annotate, annotation_threads);
+  variant_list.weight_position = weight_position;
+  return variant_list;
+} // extract_translated
 
-  // First some base cases to end the recursion.
-  // No more reference string.
-  if (reference_length <= 0)
+// Only used to interface to Python: the variants as a flat array of
+// records (see serialize_variants in extractor.h).
+void serialize_variants(uint64_t                    record[],
+                        std::vector<Variant> const &variant)
+{
+  for (size_t i = 0; i < variant.size(); ++i)
   {
-    // But some of the sample string is remaining: this is an
-    // insertion or transposition.
-    if (sample_length > 0)
+    uint64_t* const field = record + i * VARIANT_RECORD_FIELDS;
+    field[0] = variant[i].reference_start;
+    field[1] = variant[i].reference_end;
+    field[2] = variant[i].sample_start;
+    field[3] = variant[i].sample_end;
+    field[4] = variant[i].type;
+    if (variant[i].type & FRAME_SHIFT)
     {
-      weight = 2 * weight_position + WEIGHT_SEPARATOR + WEIGHT_INSERTION + WEIGHT_BASE * sample_length;
-
-      // First, we check if we can match the inserted substring
-      // somewhere in the complete reference string. This will
-      // indicate a possible transposition. Otherwise it is a regular
-      // insertion.
-      std::vector<Variant> transposition;
-      size_t const weight_transposition = extractor_transposition(transposition, reference, complement, reference_start, reference_end, sample, sample_start, sample_end, weight) + 2 * weight_position + 3 * WEIGHT_SEPARATOR + WEIGHT_INSERTION;
+      memcpy(&field[5], &variant[i].probability, sizeof(double));
+    } // if
+    else
+    {
+      field[5] = variant[i].weight;
+    } // else
+    field[6] = variant[i].transposition_start;
+    field[7] = variant[i].transposition_end;
+    field[8] = variant[i].shift5;
+    field[9] = variant[i].shift3;
+    field[10] = variant[i].palindrome;
+  } // for
+  return;
+} // serialize_variants
 
+// Appends a (one-based) position or range to a description.
+static void describe_range(std::string &description,
+                           size_t const start,
+                           size_t const end)
+{
+  description += std::to_string(start);
+  if (start != end)
+  {
+    description += '_';
+    description += std::to_string(end);
+  } // if
+  return;
+} // describe_range
 
-#if defined(__debug__)
-  fprintf(stderr, "Transpositions: %ld (trivial: %ld)\n", weight_transposition, weight);
-  for (std::vector<Variant>::const_iterator it = transposition.begin(); it != transposition.end(); ++it)
+// Appends a list of inserted parts to a description. Multiple parts
+// are enclosed in square brackets.
+static void describe_list(std::string                    &description,
+                          std::vector<std::string> const &item)
+{
+  if (item.size() > 1)
   {
-    fprintf(stderr, "  %ld--%ld, %ld--%ld, %d, %ld, %ld--%ld\n", it->reference_start, it->reference_end, it->sample_start, it->sample_end, it->type, it->weight, it->transposition_start, it->transposition_end);
+    description += '[';
+  } // if
+  for (size_t i = 0; i < item.size(); ++i)
+  {
+    if (i > 0)
+    {
+      description += ';';
+    } // if
+    description += item[i];
   } // for
-#endif
-
+  if (item.size() > 1)
+  {
+    description += ']';
+  } // if
+  return;
+} // describe_list
+
+// Describes a single variant. The inserted parts of a transposition
+// are given, otherwise the inserted part is taken from the sample
+// string. The shifted position of an insertion is checked against the
+// lengths of the strings.
+static std::string describe_dna_variant(char_t const* const             reference,
+                                        size_t const                    reference_length,
+                                        char_t const* const             sample,
+                                        size_t const                    sample_length,
+                                        Variant const&                  variant,
+                                        std::vector<std::string> const* inserted)
+{
+  std::string description;
 
-      // Add transpositions if any.
-      if (weight > weight_transposition && transposition.size() > 0 && !(transposition.size() == 1 && transposition.front().type == SUBSTITUTION))
+  // Insertion or duplication (shifted towards the end).
+  if (variant.reference_start == variant.reference_end)
+  {
+    size_t const length = variant.sample_end - variant.sample_start;
+    size_t const reference_start = variant.reference_start + variant.shift3;
+    size_t const sample_start = variant.sample_start + variant.shift3;
+    if (reference_start > reference_length || sample_start + length > sample_length)
+    {
+      throw std::out_of_range("shifted insertion out of range of the strings");
+    } // if
+    if (reference_start >= length && sample_start >= length &&
+        string_match(reference + reference_start - length, sample + sample_start, length) &&
+        string_match(sample + sample_start - length, sample + sample_start, length))
+    {
+      bool masked = false;
+      for (size_t i = 0; i < length; ++i)
       {
-        transposition.front().type |= TRANSPOSITION_OPEN;
-        transposition.back().type |= TRANSPOSITION_CLOSE;
-        variant.insert(variant.end(), transposition.begin(), transposition.end());
-        return weight_transposition;
+        masked = masked || reference[reference_start - length + i] == MASK || sample[sample_start + i] == MASK;
+      } // for
+      if (!masked)
+      {
+        describe_range(description, reference_start - length + 1, reference_start);
+        description += "dup";
+        return description;
       } // if
+    } // if
 
-      // This is an actual insertion.
-      variant.push_back(Variant(reference_start, reference_end, sample_start, sample_end, SUBSTITUTION, weight));
+    describe_range(description, reference_start, reference_start + 1);
+    description += "ins";
+    if (inserted != 0)
+    {
+      describe_list(description, *inserted);
     } // if
-    return weight;
+    else
+    {
+      description.append(sample + sample_start, length);
+    } // else
+    return description;
   } // if
 
-  // Obviously there is a piece of reference string left, but no more
-  // sample string: this is a deletion.
-  if (sample_length <= 0)
+  // Deletion (shifted towards the end).
+  if (variant.sample_start == variant.sample_end)
   {
-    weight = weight_position + WEIGHT_DELETION + (reference_length > 1 ? weight_position + WEIGHT_SEPARATOR : 0);
-    variant.push_back(Variant(reference_start, reference_end, sample_start, sample_end, SUBSTITUTION, weight));
-    return weight;
+    describe_range(description, variant.reference_start + variant.shift3 + 1, variant.reference_end + variant.shift3);
+    description += "del";
+    return description;
   } // if
 
-  // Single-nucleotide polymorphism (SNP): a special case for HGVS.
-  if (reference_length == 1 && sample_length == 1)
+  // Substitution.
+  if (variant.reference_start + 1 == variant.reference_end && variant.sample_start + 1 == variant.sample_end)
   {
-    weight = weight_position + 2 * WEIGHT_BASE + WEIGHT_SUBSTITUTION;
-    variant.push_back(Variant(reference_start, reference_end, sample_start, sample_end, SUBSTITUTION, weight));
-    return weight;
+    description += std::to_string(variant.reference_start + 1);
+    description += reference[variant.reference_start];
+    description += '>';
+    description += sample[variant.sample_start];
+    return description;
   } // if
 
-
-  // Calculate the LCS (possibly in reverse complement) of the two
-  // strings.
-  size_t const cut_off = reference_length < THRESHOLD_CUT_OFF ? 1 : weight_position;
-  std::vector<Substring> substring;
-  size_t const length = LCS(substring, reference, complement, reference_start, reference_end, sample, sample_start, sample_end, cut_off);
-
-
-  // No LCS found: this is a transposition or a deletion/insertion.
-  if (length <= 0 || substring.size() <= 0)
+  // Inversion (without its palindromic prefix and suffix).
+  if (variant.type & REVERSE_COMPLEMENT)
   {
-    weight = weight_trivial;
-
-    // First, we check if we can match the inserted substring
-    // somewhere in the complete reference string. This will
-    // indicate a possible transposition.
-    std::vector<Variant> transposition;
-    size_t const weight_transposition = extractor_transposition(transposition, reference, complement, reference_start, reference_end, sample, sample_start, sample_end, weight)  + 2 * weight_position + 3 * WEIGHT_SEPARATOR + WEIGHT_DELETION_INSERTION;
-
+    describe_range(description, variant.reference_start + 1, variant.reference_end - variant.palindrome);
+    description += "inv";
+    return description;
+  } // if
 
-#if defined(__debug__)
-  fprintf(stderr, "Transpositions: %ld (trivial: %ld)\n", weight_transposition, weight);
-  for (std::vector<Variant>::const_iterator it = transposition.begin(); it != transposition.end(); ++it)
+  // Deletion/insertion.
+  describe_range(description, variant.reference_start + 1, variant.reference_end);
+  description += "delins";
+  if (inserted != 0)
   {
-    fprintf(stderr, "  %ld--%ld, %ld--%ld, %d, %ld, %ld--%ld\n", it->reference_start, it->reference_end, it->sample_start, it->sample_end, it->type, it->weight, it->transposition_start, it->transposition_end);
-  } // for
-#endif
+    describe_list(description, *inserted);
+  } // if
+  else
+  {
+    description.append(sample + variant.sample_start, variant.sample_end - variant.sample_start);
+  } // else
+  return description;
+} // describe_dna_variant
+
+// Only used to interface to Python: the HGVS allele description of
+// the extracted variants without constructing intermediate objects.
+std::string describe_dna_allele(char_t const* const         reference,
+                                size_t const                reference_length,
+                                char_t const* const         sample,
+                                size_t const                sample_length,
+                                std::vector<Variant> const &variant)
+{
+  std::vector<std::string> description;
+  std::vector<std::string> inserted;
+  size_t transposition = 0;
+  for (std::vector<Variant>::const_iterator it = variant.begin(); it != variant.end(); ++it)
+  {
+    if (it->reference_start > it->reference_end || it->reference_end > reference_length ||
+        it->sample_start > it->sample_end || it->sample_end > sample_length)
+    {
+      throw std::out_of_range("variant out of range of the strings");
+    } // if
 
+    if (it->type & TRANSPOSITION_OPEN)
+    {
+      if (transposition == 0)
+      {
+        inserted.clear();
+      } // if
+      ++transposition;
+    } // if
 
-    // Add transpositions if any.
-    if (weight > weight_transposition && transposition.size() > 0 && !(transposition.size() == 1 && transposition.front().type == SUBSTITUTION))
+    // The parts of a transposition are either (inverted) reference
+    // ranges or literal sample strings.
+    if (transposition > 0)
     {
-      transposition.front().type |= TRANSPOSITION_OPEN;
-      transposition.back().type |= TRANSPOSITION_CLOSE;
-      variant.insert(variant.end(), transposition.begin(), transposition.end());
-      return weight_transposition;
+      if (it->type & (IDENTITY | REVERSE_COMPLEMENT))
+      {
+        std::string part;
+        describe_range(part, it->transposition_start + 1, it->transposition_end);
+        if ((it->type & IDENTITY) == 0 && it->transposition_start + 1 != it->transposition_end)
+        {
+          part += "inv";
+        } // if
+        inserted.push_back(part);
+      } // if
+      else
+      {
+        inserted.push_back(std::string(sample + it->sample_start, it->sample_end - it->sample_start));
+      } // else
+    } // if
+    else if ((it->type & IDENTITY) == 0)
+    {
+      description.push_back(describe_dna_variant(reference, reference_length, sample, sample_length, *it, 0));
     } // if
 
-    // This is an actual deletion/insertion.
-    variant.push_back(Variant(reference_start, reference_end, sample_start, sample_end, SUBSTITUTION, weight_trivial));
-    return weight_trivial;
-  } // if
-
+    if (it->type & TRANSPOSITION_CLOSE)
+    {
+      --transposition;
+      if (transposition == 0)
+      {
+        description.push_back(describe_dna_variant(reference, reference_length, sample, sample_length, *it, &inserted));
+      } // if
+    } // if
+  } // for
 
-  // Pick the ``best fitting'' LCS, i.e., the remaining prefixes and
-  // suffixes are of the same length.
-  size_t diff = (reference_end - reference_start) + (sample_end - sample_start);
-  std::vector<Substring>::const_iterator lcs = substring.begin();
-  for (std::vector<Substring>::const_iterator it = substring.begin(); it != substring.end(); ++it)
+  if (description.empty())
   {
-    size_t const prefix_diff = abs((it->reference_index - reference_start) - (it->sample_index - sample_start));
-    size_t const suffix_diff = abs((reference_end - (it->reference_index + it->length)) - (sample_end - (it->sample_index + it->length)));
-    if (prefix_diff + suffix_diff < diff)
+    return "=";
+  } // if
+  std::string allele;
+  describe_list(allele, description);
+  return allele;
+} // describe_dna_allele
+
+// Appends a segment to a protein variant.
+static void add_protein_segment(Protein_Variant   &protein_variant,
+                                size_t const       reference_start,
+                                size_t const       reference_end,
+                                size_t const       sample_start,
+                                size_t const       sample_end,
+                                unsigned int const type)
+{
+  static char const* const FRAMES[] = {"1", "2", "inv", "1inv", "2inv"};
+  static unsigned int const FRAME_TYPE[] = {FRAME_SHIFT_1, FRAME_SHIFT_2, FRAME_SHIFT_REVERSE, FRAME_SHIFT_REVERSE_1, FRAME_SHIFT_REVERSE_2};
+
+  protein_variant.segments.push_back(Protein_Segment());
+  Protein_Segment &segment = protein_variant.segments.back();
+  segment.reference_start = reference_start;
+  segment.reference_end = reference_end;
+  segment.sample_start = sample_start;
+  segment.sample_end = sample_end;
+  for (size_t i = 0; i < sizeof(FRAME_TYPE) / sizeof(FRAME_TYPE[0]); ++i)
+  {
+    if (type & FRAME_TYPE[i])
     {
-      // A better fitting LCS.
-      diff = prefix_diff + suffix_diff;
-      lcs = it;
+      segment.frames.push_back(FRAMES[i]);
     } // if
   } // for
+  return;
+} // add_protein_segment
+
+// Only used to interface to Python: groups the variants with their
+// frame shift annotations. NOTE: the filling of the unannotated parts
+// starts at the reference starting position of the variant following
+// the grouped variant (as in the original description); at the end
+// of the list it starts at the sample starting position.
+std::vector<Protein_Variant> group_protein_variants(std::vector<Variant> const &variant)
+{
+  std::vector<Protein_Variant> protein_variant;
+  size_t i = 0;
+  while (i < variant.size())
+  {
+    if (variant[i].type == IDENTITY)
+    {
+      ++i;
+      continue;
+    } // if
 
+    Protein_Variant grouped;
+    grouped.variant = variant[i];
+    ++i;
 
-  // Add some weight for reverse complement LCS.
-  if (lcs->reverse_complement)
-  {
-    weight = 2 * weight_position + WEIGHT_SEPARATOR + WEIGHT_INVERSION;
-  } // if
+    size_t last_end = i < variant.size() ? variant[i].reference_start : grouped.variant.sample_start;
+    while (i < variant.size() && (variant[i].type & FRAME_SHIFT))
+    {
+      if (last_end < variant[i].sample_start)
+      {
+        add_protein_segment(grouped, 0, 0, last_end, variant[i].sample_start, 0);
+      } // if
+      last_end = variant[i].sample_end;
+      add_protein_segment(grouped, variant[i].reference_start, variant[i].reference_end, variant[i].sample_start, variant[i].sample_end, variant[i].type);
+      ++i;
+    } // while
 
+    if (last_end < grouped.variant.sample_end)
+    {
+      add_protein_segment(grouped, 0, 0, last_end, grouped.variant.sample_end, 0);
+    } // if
+    protein_variant.push_back(std::move(grouped));
+  } // while
+  return protein_variant;
+} // group_protein_variants
+
+// Finds all (possibly overlapping) occurrences of the repeat units in
+// a string in one pass using an Aho-Corasick automaton. The automaton
+// is stored as a complete transition table (on bytes) with 0 (the
+// root) as a sentinel for absent edges and absent output links. The
+// starting positions are stored in order per unit.
+static void find_occurrences(std::vector<std::vector<size_t> > &occurrence,
+                             char_t const* const                string,
+                             size_t const                       length,
+                             std::vector<std::string> const    &unit)
+{
+  static size_t const ALPHABET = 256;
 
-#if defined(__debug__)
-  fprintf(stderr, "  LCS (x%ld)\n", substring.size());
-  for (std::vector<Substring>::const_iterator it = substring.begin() ; it != substring.end(); ++it)
+  // The trie of all (non-empty) units.
+  std::vector<size_t> transition(ALPHABET, 0);
+  std::vector<std::vector<size_t> > terminal(1);
+  for (size_t i = 0; i < unit.size(); ++i)
   {
-    if (!it->reverse_complement)
+    if (unit[i].empty())
     {
-      fprintf(stderr, "    %ld--%ld: ", it->reference_index, it->reference_index + length);
-      Dprint_truncated(reference, it->reference_index, it->reference_index + length);
-      fprintf(stderr, " (%ld)\n    %ld--%ld: ", length, it->sample_index, it->sample_index + length);
-      Dprint_truncated(sample, it->sample_index, it->sample_index + length);
-      fprintf(stderr, " (%ld)", length);
+      continue;
     } // if
-    else
+    size_t state = 0;
+    for (size_t j = 0; j < unit[i].size(); ++j)
     {
-      fprintf(stderr, "    %ld--%ld: ", it->reference_index, it->reference_index + length);
-      Dprint_truncated(complement, it->reference_index, it->reference_index + length);
-      fprintf(stderr, " (%ld), (reverse complement)\n    %ld--%ld: ", length, it->sample_index, it->sample_index + length);
-      Dprint_truncated(sample, it->sample_index, it->sample_index + length);
-      fprintf(stderr, " (%ld)", length);
-    } // else
-    fputs("\n", stderr);
+      size_t const index = state * ALPHABET + static_cast<unsigned char>(unit[i][j]);
+      if (transition[index] == 0)
+      {
+        transition[index] = terminal.size();
+        transition.resize(transition.size() + ALPHABET, 0);
+        terminal.push_back(std::vector<size_t>());
+      } // if
+      state = transition[index];
+    } // for
+    terminal[state].push_back(i);
   } // for
-#endif
-
 
-  // Recursively apply this function to the prefixes of the strings.
-  std::vector<Variant> prefix;
-  weight += extractor(prefix, reference, complement, reference_start, lcs->reference_index, sample, sample_start, lcs->sample_index);
+  // The failure transitions are resolved in breadth-first order, such
+  // that the transitions of the failure state are already complete.
+  std::vector<size_t> failure(terminal.size(), 0);
+  std::vector<size_t> output(terminal.size(), 0);
+  std::vector<size_t> queue(1, 0);
+  for (size_t k = 0; k < queue.size(); ++k)
+  {
+    size_t const state = queue[k];
+    for (size_t c = 0; c < ALPHABET; ++c)
+    {
+      size_t const child = transition[state * ALPHABET + c];
+      if (child != 0)
+      {
+        failure[child] = state == 0 ? 0 : transition[failure[state] * ALPHABET + c];
+        output[child] = terminal[failure[child]].empty() ? output[failure[child]] : failure[child];
+        queue.push_back(child);
+      } // if
+      else if (state != 0)
+      {
+        transition[state * ALPHABET + c] = transition[failure[state] * ALPHABET + c];
+      } // if
+    } // for
+  } // for
 
-  // Stop if the weight of the variant exeeds the trivial weight.
-  if (weight > weight_trivial)
+  occurrence.assign(unit.size(), std::vector<size_t>());
+  size_t state = 0;
+  for (size_t i = 0; i < length; ++i)
   {
-    weight = weight_trivial;
+    state = transition[state * ALPHABET + static_cast<unsigned char>(string[i])];
+    for (size_t match = terminal[state].empty() ? output[state] : state; match != 0; match = output[match])
+    {
+      for (std::vector<size_t>::const_iterator it = terminal[match].begin(); it != terminal[match].end(); ++it)
+      {
+        occurrence[*it].push_back(i + 1 - unit[*it].size());
+      } // for
+    } // for
+  } // for
+  return;
+} // find_occurrences
+
+// Only used to interface to Python: masks the repeat units in a
+// string. An occurrence is only masked if it does not overlap an
+// earlier masked occurrence. An occurrence directly following the
+// last masked repeat extends that repeat.
+Masked_String mask_repeats(char_t const* const             string,
+                           size_t const                    length,
+                           std::vector<std::string> const &unit)
+{
+  std::vector<std::vector<size_t> > occurrence;
+  find_occurrences(occurrence, string, length, unit);
 
-    // First, we check if we can match the inserted substring
-    // somewhere in the complete reference string. This will
-    // indicate a possible transposition.
-    std::vector<Variant> transposition;
-    size_t const weight_transposition = extractor_transposition(transposition, reference, complement, reference_start, reference_end, sample, sample_start, sample_end, weight)  + 2 * weight_position + 3 * WEIGHT_SEPARATOR + WEIGHT_DELETION_INSERTION;
+  Masked_String masked;
+  masked.string.assign(string, length);
+  for (size_t i = 0; i < unit.size(); ++i)
+  {
+    size_t const unit_length = unit[i].size();
+    size_t next = 0;
+    for (std::vector<size_t>::const_iterator it = occurrence[i].begin(); it != occurrence[i].end(); ++it)
+    {
+      if (*it < next || std::find(masked.string.begin() + *it, masked.string.begin() + *it + unit_length, MASK) != masked.string.begin() + *it + unit_length)
+      {
+        continue;
+      } // if
 
+      if (!masked.repeats.empty() && masked.repeats.back().start + masked.repeats.back().count * unit_length == *it)
+      {
+        ++masked.repeats.back().count;
+      } // if
+      else
+      {
+        masked.repeats.push_back(Masked_Repeat());
+        masked.repeats.back().start = *it;
+        masked.repeats.back().count = 1;
+        masked.repeats.back().unit = i;
+      } // else
+      masked.string.replace(*it, unit_length, unit_length, MASK);
+      next = *it + unit_length;
+    } // for
+  } // for
 
-#if defined(__debug__)
-  fprintf(stderr, "Transpositions: %ld (trivial: %ld)\n", weight_transposition, weight);
-  for (std::vector<Variant>::const_iterator it = transposition.begin(); it != transposition.end(); ++it)
+  std::sort(masked.repeats.begin(), masked.repeats.end(), [](Masked_Repeat const& lhs, Masked_Repeat const& rhs)
   {
-    fprintf(stderr, "  %ld--%ld, %ld--%ld, %d, %ld, %ld--%ld\n", it->reference_start, it->reference_end, it->sample_start, it->sample_end, it->type, it->weight, it->transposition_start, it->transposition_end);
-  } // for
-#endif
+    return lhs.start < rhs.start;
+  });
+  return masked;
+} // mask_repeats
+
+// Only used to interface to Python: splits the variants at the masked
+// regions of the sample string. A variant is split at every masked
+// region, possibly yielding empty parts at its boundaries.
+std::vector<Variant> split_masked_variants(char_t const* const         sample,
+                                           size_t const                sample_length,
+                                           std::vector<Variant> const &variant,
+                                           size_t const                reference_offset)
+{
+  std::vector<Variant> split;
+  for (std::vector<Variant>::const_iterator it = variant.begin(); it != variant.end(); ++it)
+  {
+    if (it->sample_start > it->sample_end || it->sample_end > sample_length)
+    {
+      throw std::out_of_range("variant out of range of the sample string");
+    } // if
 
+    size_t const size = split.size();
+    size_t i = it->sample_start;
+    size_t start = i;
+    while (i < it->sample_end)
+    {
+      while (i < it->sample_end && sample[i] != MASK)
+      {
+        ++i;
+      } // while
+      if (i < it->sample_end)
+      {
+        split.push_back(Variant(it->reference_start + reference_offset, it->reference_end + reference_offset, start, i, it->type, 0, it->transposition_start + reference_offset, it->transposition_end + reference_offset));
+        while (i < it->sample_end && sample[i] == MASK)
+        {
+          ++i;
+        } // while
+        start = i;
+      } // if
+    } // while
 
-    // Add transpositions if any.
-    if (weight > weight_transposition && transposition.size() > 0 && !(transposition.size() == 1 && transposition.front().type == SUBSTITUTION))
+    if (split.size() > size)
     {
-      transposition.front().type |= TRANSPOSITION_OPEN;
-      transposition.back().type |= TRANSPOSITION_CLOSE;
-      variant.insert(variant.end(), transposition.begin(), transposition.end());
-      return weight_transposition;
+      split.push_back(Variant(it->reference_start + reference_offset, it->reference_end + reference_offset, start, it->sample_end, it->type, 0, it->transposition_start + reference_offset, it->transposition_end + reference_offset));
     } // if
+    else
+    {
+      split.push_back(*it);
+    } // else
+  } // for
+  return split;
+} // split_masked_variants
 
-    // This is an actual deletion/insertion.
-    variant.push_back(Variant(reference_start, reference_end, sample_start, sample_end, SUBSTITUTION, weight_trivial));
-    return weight_trivial;
-  } // if
+// Longest common extension (LCE) queries in constant time: the ranks
+// of the suffix array and its LCP array stored as a sparse table for
+// range minimum queries.
+struct LCE_Table
+{
+  std::vector<size_t>                rank;
+  std::vector<std::vector<size_t> > minimum;
+  std::vector<size_t>                log;
+}; // LCE_Table
+
+// Prepares the LCE table of a string. The suffix array is constructed
+// by prefix doubling (with radix sorting) and the LCP array by
+// Kasai's algorithm.
+static void prepare_LCE_table(LCE_Table          &table,
+                              char_t const* const string,
+                              size_t const        length)
+{
+  std::vector<size_t> suffix(length);
+  std::vector<size_t>& rank = table.rank;
+  rank.resize(length);
+  std::vector<size_t> temp(length);
+  std::vector<size_t> count(std::max(static_cast<size_t>(256), length) + 1);
 
-  // Recursively apply this function to the suffixes of the strings.
-  std::vector<Variant> suffix;
-  weight += extractor(suffix, reference, complement, lcs->reference_index + length, reference_end, sample, lcs->sample_index + length, sample_end);
+  for (size_t i = 0; i < length; ++i)
+  {
+    suffix[i] = i;
+    rank[i] = static_cast<unsigned char>(string[i]);
+  } // for
+  std::sort(suffix.begin(), suffix.end(), [&rank](size_t const lhs, size_t const rhs)
+  {
+    return rank[lhs] < rank[rhs];
+  });
 
-  // Stop if the weight of the variant exeeds the trivial weight.
-  if (weight > weight_trivial)
+  for (size_t k = 1; length > 1; k *= 2)
   {
-    weight = weight_trivial;
+    // Sort on the second half (the suffixes without a second half
+    // first), and then (stable) on the first half.
+    size_t j = 0;
+    for (size_t i = length > k ? length - k : 0; i < length; ++i)
+    {
+      temp[j++] = i;
+    } // for
+    for (size_t i = 0; i < length; ++i)
+    {
+      if (suffix[i] >= k)
+      {
+        temp[j++] = suffix[i] - k;
+      } // if
+    } // for
+    std::fill(count.begin(), count.end(), 0);
+    for (size_t i = 0; i < length; ++i)
+    {
+      ++count[rank[i] + 1];
+    } // for
+    for (size_t i = 1; i < count.size(); ++i)
+    {
+      count[i] += count[i - 1];
+    } // for
+    for (size_t i = 0; i < length; ++i)
+    {
+      suffix[count[rank[temp[i]]]++] = temp[i];
+    } // for
 
-    // First, we check if we can match the inserted substring
-    // somewhere in the complete reference string. This will
-    // indicate a possible transposition.
-    std::vector<Variant> transposition;
-    size_t const weight_transposition = extractor_transposition(transposition, reference, complement, reference_start, reference_end, sample, sample_start, sample_end, weight)  + 2 * weight_position + 3 * WEIGHT_SEPARATOR + WEIGHT_DELETION_INSERTION;
+    temp[suffix[0]] = 0;
+    for (size_t i = 1; i < length; ++i)
+    {
+      size_t const lhs = suffix[i - 1];
+      size_t const rhs = suffix[i];
+      bool const equal = rank[lhs] == rank[rhs] && (lhs + k < length ? rhs + k < length && rank[lhs + k] == rank[rhs + k] : rhs + k >= length);
+      temp[rhs] = temp[lhs] + (equal ? 0 : 1);
+    } // for
+    rank.swap(temp);
+    if (rank[suffix[length - 1]] == length - 1)
+    {
+      break;
+    } // if
+  } // for
+  if (length == 1)
+  {
+    rank[0] = 0;
+  } // if
 
+  // The LCP array: minimum[0][r] is the length of the common prefix
+  // of the suffixes with rank r - 1 and r.
+  table.minimum.assign(1, std::vector<size_t>(length, 0));
+  size_t h = 0;
+  for (size_t i = 0; i < length; ++i)
+  {
+    if (rank[i] > 0)
+    {
+      size_t const j = suffix[rank[i] - 1];
+      while (i + h < length && j + h < length && string[i + h] == string[j + h])
+      {
+        ++h;
+      } // while
+      table.minimum[0][rank[i]] = h;
+      if (h > 0)
+      {
+        --h;
+      } // if
+    } // if
+    else
+    {
+      h = 0;
+    } // else
+  } // for
 
-#if defined(__debug__)
-  fprintf(stderr, "Transpositions: %ld (trivial: %ld)\n", weight_transposition, weight);
-  for (std::vector<Variant>::const_iterator it = transposition.begin(); it != transposition.end(); ++it)
+  table.log.assign(length + 1, 0);
+  for (size_t i = 2; i <= length; ++i)
   {
-    fprintf(stderr, "  %ld--%ld, %ld--%ld, %d, %ld, %ld--%ld\n", it->reference_start, it->reference_end, it->sample_start, it->sample_end, it->type, it->weight, it->transposition_start, it->transposition_end);
+    table.log[i] = table.log[i / 2] + 1;
   } // for
-#endif
+  for (size_t j = 1; (static_cast<size_t>(1) << j) <= length; ++j)
+  {
+    size_t const half = static_cast<size_t>(1) << (j - 1);
+    table.minimum.push_back(std::vector<size_t>(length - 2 * half + 1));
+    for (size_t i = 0; i + 2 * half <= length; ++i)
+    {
+      table.minimum[j][i] = std::min(table.minimum[j - 1][i], table.minimum[j - 1][i + half]);
+    } // for
+  } // for
+  return;
+} // prepare_LCE_table
 
+// The length of the longest common prefix of two (different)
+// suffixes.
+static size_t LCE(LCE_Table const& table,
+                  size_t const     i,
+                  size_t const     j)
+{
+  size_t const lower = std::min(table.rank[i], table.rank[j]) + 1;
+  size_t const upper = std::max(table.rank[i], table.rank[j]) + 1;
+  size_t const level = table.log[upper - lower];
+  return std::min(table.minimum[level][lower], table.minimum[level][upper - (static_cast<size_t>(1) << level)]);
+} // LCE
+
+// Calculates the runs (maximal repetitions) of a string as (start,
+// end, period) triples using the Lyndon roots of the runs: for both
+// the alphabet order and its inverse the longest Lyndon words
+// starting at every position are calculated (next smaller suffix),
+// and extended in both directions.
+static void runs(std::vector<Repeat> &run,
+                 char_t const* const  string,
+                 size_t const         length)
+{
+  LCE_Table forward;
+  prepare_LCE_table(forward, string, length);
+  std::vector<char_t> reverse(string, string + length);
+  std::reverse(reverse.begin(), reverse.end());
+  LCE_Table backward;
+  prepare_LCE_table(backward, reverse.data(), length);
+
+  std::vector<size_t> lyndon(length);
+  std::vector<size_t> stack;
+  for (int order = 0; order < 2; ++order)
+  {
+    stack.clear();
+    for (size_t i = length; i > 0; )
+    {
+      --i;
+      while (!stack.empty())
+      {
+        // Compare the suffixes at i and at the top of the stack: a
+        // proper prefix is always smaller.
+        size_t const j = stack.back();
+        size_t const extension = LCE(forward, i, j);
+        bool const smaller = i + extension == length || (j + extension < length &&
+                             (order == 0 ? static_cast<unsigned char>(string[i + extension]) < static_cast<unsigned char>(string[j + extension])
+                                         : static_cast<unsigned char>(string[i + extension]) > static_cast<unsigned char>(string[j + extension])));
+        if (!smaller)
+        {
+          break;
+        } // if
+        stack.pop_back();
+      } // while
+      lyndon[i] = stack.empty() ? length : stack.back();
+      stack.push_back(i);
+    } // for
 
-    // Add transpositions if any.
-    if (weight > weight_transposition && transposition.size() > 0 && !(transposition.size() == 1 && transposition.front().type == SUBSTITUTION))
+    for (size_t i = 0; i < length; ++i)
     {
-      transposition.front().type |= TRANSPOSITION_OPEN;
-      transposition.back().type |= TRANSPOSITION_CLOSE;
-      variant.insert(variant.end(), transposition.begin(), transposition.end());
-      return weight_transposition;
-    } // if
+      size_t const j = lyndon[i];
+      size_t const period = j - i;
+      size_t const right = j < length ? LCE(forward, i, j) : 0;
+      size_t const left = i > 0 ? LCE(backward, length - i, length - j) : 0;
+      if (left + right >= period)
+      {
+        run.push_back(Repeat(i - left, j + right, period));
+      } // if
+    } // for
+  } // for
 
-    // This is an actual deletion/insertion.
-    variant.push_back(Variant(reference_start, reference_end, sample_start, sample_end, SUBSTITUTION, weight_trivial));
-    return weight_trivial;
-  } // if
+  std::sort(run.begin(), run.end(), [](Repeat const& lhs, Repeat const& rhs)
+  {
+    return lhs.start < rhs.start || (lhs.start == rhs.start && (lhs.end < rhs.end || (lhs.end == rhs.end && lhs.count < rhs.count)));
+  });
+  run.erase(std::unique(run.begin(), run.end(), [](Repeat const& lhs, Repeat const& rhs)
+  {
+    return lhs.start == rhs.start && lhs.end == rhs.end && lhs.count == rhs.count;
+  }), run.end());
+  return;
+} // runs
+
+// Extracts the short tandem repeat structure of a string. A square
+// with unit length k at position i is always contained in a run with
+// a period p dividing k, and then the number of repetitions following
+// the unit is (end - i) / k - 1. So only the runs containing a square
+// at the current position are considered.
+std::vector<Repeat> short_tandem_repeats(char_t const* const string,
+                                         size_t const        length,
+                                         size_t const        min_length,
+                                         size_t const        max_length)
+{
+  std::vector<Repeat> run;
+  runs(run, string, length);
 
+  std::vector<Repeat> repeat;
+  std::vector<Repeat> active;
+  size_t next = 0;
+  size_t last = 0;
+  size_t i = 0;
+  while (i < length)
+  {
+    while (next < run.size() && run[next].start <= i)
+    {
+      active.push_back(run[next]);
+      ++next;
+    } // while
 
-  // Add all variants (in order) to the variant vector.
-  variant.insert(variant.end(), prefix.begin(), prefix.end());
+    size_t best_count = 0;
+    size_t best_length = 1;
+    for (size_t j = 0; j < active.size(); )
+    {
+      size_t const period = active[j].count;
+      if (active[j].end < i + 2 * period)
+      {
+        active[j] = active.back();
+        active.pop_back();
+        continue;
+      } // if
+      size_t const available = active[j].end - i;
+      ++j;
+
+      // The shortest multiple of the period gives the most
+      // repetitions; the longest multiple with the same number of
+      // repetitions is taken.
+      size_t const shortest = std::max(static_cast<size_t>(1), (min_length + period - 1) / period) * period;
+      if (2 * shortest > available || (max_length > 0 && shortest > max_length))
+      {
+        continue;
+      } // if
+      size_t const count = available / shortest - 1;
+      size_t longest = available / ((count + 1) * period);
+      if (max_length > 0 && longest > max_length / period)
+      {
+        longest = max_length / period;
+      } // if
+      longest *= period;
+      if (count > best_count || (count == best_count && longest > best_length))
+      {
+        best_count = count;
+        best_length = longest;
+      } // if
+    } // for
 
-  if (!lcs->reverse_complement)
+    if (best_count > 0)
+    {
+      if (last < i)
+      {
+        repeat.push_back(Repeat(last, i));
+      } // if
+      repeat.push_back(Repeat(i, i + best_length, best_count));
+      last = i + best_length * (best_count + 1);
+      i = last;
+    } // if
+    else
+    {
+      ++i;
+    } // else
+  } // while
+
+  if (last < i)
   {
-    variant.push_back(Variant(lcs->reference_index, lcs->reference_index + length, lcs->sample_index, lcs->sample_index + length));
+    repeat.push_back(Repeat(last, i));
   } // if
-  else
+  return repeat;
+} // short_tandem_repeats
+
+// Only used to interface to Python: extracts a batch of string pairs
+// on a number of worker threads sharing one prepared codon table. The
+// results are stored in order.
+std::vector<Variant_List> extract_batch(std::vector<std::string> const& reference,
+                                        std::vector<std::string> const& sample,
+                                        int const                       type,
+                                        char_t const* const             codon_string,
+                                        size_t const                    threads,
+                                        bool const                      annotate)
+{
+  if (reference.size() != sample.size())
   {
-    variant.push_back(Variant(lcs->reference_index, lcs->reference_index + length, lcs->sample_index, lcs->sample_index + length, REVERSE_COMPLEMENT, 2 * weight_position + WEIGHT_SEPARATOR + WEIGHT_INVERSION));
-  } // else
+    throw std::invalid_argument("the numbers of reference and sample strings differ");
+  } // if
 
-  variant.insert(variant.end(), suffix.begin(), suffix.end());
+  size_t const pairs = reference.size();
+  std::vector<Variant_List> variant_list(pairs);
+  Codon_Table const* const codon_table = type == TYPE_PROTEIN ? get_codon_table(codon_string) : 0;
 
-  return weight;
-} // extractor
+  parallel_for(pairs, threads, [&](size_t const i)
+  {
+    extract_variants(variant_list[i].variants, reference[i].data(), reference[i].size(), sample[i].data(), sample[i].size(), type, codon_table, annotate, 1);
+    variant_list[i].weight_position = weight_position;
+  });
 
-// This function tries to extract transpositions from inserted
-// sequences (insertions or deletion/insertions). Again we use a
-// recursive method: extract the LCS and apply to the remaining prefix
-// and suffix.
-size_t extractor_transposition(std::vector<Variant> &variant,
-                               char_t const* const   reference,
-                               char_t const* const   complement,
-                               size_t const          reference_start,
-                               size_t const          reference_end,
-                               char_t const* const   sample,
-                               size_t const          sample_start,
-                               size_t const          sample_end,
-                               size_t const          weight_trivial)
+  return variant_list;
+} // extract_batch
+
+// A queued asynchronous extraction. The strings are owned by the job.
+struct Extraction_Job
 {
-  size_t const sample_length = sample_end - sample_start;
+  size_t             identifier;
+  std::string        reference;
+  std::string        sample;
+  int                type;
+  Codon_Table const* codon_table;
+  bool               annotate;
+}; // Extraction_Job
+
+// The pool of worker threads for the asynchronous extractions. The
+// completions are signalled by writing to a (non-blocking) pipe. The
+// completed extractions are kept until their results are taken, the
+// failed extractions keep their exception.
+struct Extraction_Pool
+{
+  std::mutex                                     mutex;
+  std::condition_variable                        queued;
+  std::condition_variable                        finished;
+  std::deque<Extraction_Job>                     queue;
+  std::unordered_set<size_t>                     pending;
+  std::unordered_map<size_t, Variant_List>       result;
+  std::unordered_map<size_t, std::exception_ptr> failure;
+  std::unordered_set<size_t>                     completed;
+  size_t                                         next_identifier;
+  int                                            signal[2];
+}; // Extraction_Pool
+
+// Takes the queued extractions one by one. The frame shift annotation
+// is not parallelized: the pool already uses all cores. An exception
+// (e.g., std::bad_alloc) fails only its own extraction.
+static void extraction_worker(Extraction_Pool &pool)
+{
+  for (;;)
+  {
+    std::unique_lock<std::mutex> lock(pool.mutex);
+    pool.queued.wait(lock, [&pool]()
+    {
+      return !pool.queue.empty();
+    });
+    Extraction_Job const job = std::move(pool.queue.front());
+    pool.queue.pop_front();
+    lock.unlock();
+
+    Variant_List variant_list;
+    std::exception_ptr failure;
+    try
+    {
+      extract_variants(variant_list.variants, job.reference.data(), job.reference.size(), job.sample.data(), job.sample.size(), job.type, job.codon_table, job.annotate, 1);
+      variant_list.weight_position = weight_position;
+    } // try
+    catch (...)
+    {
+      variant_list.variants.clear();
+      variant_list.weight_position = 1;
+      failure = std::current_exception();
+    } // catch
+
+    lock.lock();
+    pool.pending.erase(job.identifier);
+    pool.result[job.identifier] = std::move(variant_list);
+    if (failure)
+    {
+      pool.failure[job.identifier] = failure;
+    } // if
+    pool.completed.insert(job.identifier);
+    lock.unlock();
+    pool.finished.notify_all();
 
-  size_t weight = 0;
+    // A full pipe already signals a completion.
+    if (pool.signal[1] != -1)
+    {
+      char const byte = 0;
+      ssize_t const written = write(pool.signal[1], &byte, 1);
+      static_cast<void>(written);
+    } // if
+  } // for
+} // extraction_worker
+
+// The pool is created on first use. Its workers are detached, so it is
+// never destroyed: it outlives every worker at program exit.
+static Extraction_Pool* extraction_pool_instance = 0;
+static std::mutex       extraction_pool_mutex;
+
+// The workers do not survive a fork: the child abandons the pool of
+// the parent (its mutexes may be held by a worker) and creates its own
+// on first use. The pipe of the parent is left open as it may still be
+// watched. The mutexes of the pool and of the table caches are taken
+// before forking (in the order in which they are nested), such that no
+// other thread holds them while the process is copied.
+static void prepare_fork(void)
+{
+  extraction_pool_mutex.lock();
+  backtranslation_table_mutex.lock();
+  codon_table_mutex.lock();
+  return;
+} // prepare_fork
 
+static void parent_fork(void)
+{
+  codon_table_mutex.unlock();
+  backtranslation_table_mutex.unlock();
+  extraction_pool_mutex.unlock();
+  return;
+} // parent_fork
 
-#if defined(__debug__)
-  fputs("Transposition extraction\n", stderr);
-  fprintf(stderr, "  reference %ld--%ld:  ", 0ul, global_reference_length);
-  Dprint_truncated(reference, 0, global_reference_length);
-  fprintf(stderr, " (%ld)\n", global_reference_length);
-  fprintf(stderr, "  complement %ld--%ld: ", 0ul, global_reference_length);
-  Dprint_truncated(complement, 0, global_reference_length);
-  fprintf(stderr, " (%ld)\n", global_reference_length);
-  fprintf(stderr, "  sample %ld--%ld:     ", sample_start, sample_end);
-  Dprint_truncated(sample, sample_start, sample_end);
-  fprintf(stderr, " (%ld)\n", sample_length);
-  fprintf(stderr, "  trivial weight: %ld\n", weight_trivial);
-#endif
+static void child_fork(void)
+{
+  extraction_pool_instance = 0;
+  codon_table_mutex.unlock();
+  backtranslation_table_mutex.unlock();
+  extraction_pool_mutex.unlock();
+  return;
+} // child_fork
 
+// The fork handlers are installed when the library is loaded.
+static int const fork_handlers = pthread_atfork(prepare_fork, parent_fork, child_fork);
 
-  // End transposition extraction if no more of the sample string
-  // remains.
-  if (sample_length <= 0)
+static Extraction_Pool& extraction_pool(void)
+{
+  std::unique_lock<std::mutex> lock(extraction_pool_mutex);
+  if (extraction_pool_instance != 0)
   {
-    return weight;
+    return *extraction_pool_instance;
   } // if
 
-
-  // Only consider large enough inserted regions (>> 1), based on
-  // (average) description length of a position, otherwise it is just
-  // a deletion/insertion.
-  if (sample_length <= 2 * weight_position)
+  Extraction_Pool* const pool = new Extraction_Pool();
+  pool->next_identifier = 0;
+  if (pipe(pool->signal) != 0)
   {
-    weight = sample_length * WEIGHT_BASE;
-    variant.push_back(Variant(reference_start, reference_end, sample_start, sample_end, SUBSTITUTION, weight));
-    return weight;
+    pool->signal[0] = -1;
+    pool->signal[1] = -1;
   } // if
-
-
-  // Extract the LCS (from the whole reference string).
-  size_t const cut_off = global_reference_length < THRESHOLD_CUT_OFF ? 1 : TRANSPOSITION_CUT_OFF * sample_length;
-  std::vector<Substring> substring;
-  size_t const length = LCS(substring, reference, complement, 0, global_reference_length, sample, sample_start, sample_end, cut_off);
-
-
-  // No LCS found: this is a deletion/insertion.
-  if (length <= 0 || substring.size() <= 0)
+  else
   {
-    weight = sample_length * WEIGHT_BASE;
-    variant.push_back(Variant(reference_start, reference_end, sample_start, sample_end, SUBSTITUTION, weight));
-    return weight;
-  } // if
-
-  // We do NOT have to bother about a ``best fitting'' LCS here.
-  std::vector<Substring>::const_iterator const lcs = substring.begin();
+    for (size_t i = 0; i < 2; ++i)
+    {
+      fcntl(pool->signal[i], F_SETFL, fcntl(pool->signal[i], F_GETFL) | O_NONBLOCK);
+      fcntl(pool->signal[i], F_SETFD, FD_CLOEXEC);
+    } // for
+  } // else
 
-  // Update the weight of the transposition.
-  weight += 2 * weight_position + WEIGHT_SEPARATOR;
-  if (lcs->reverse_complement)
+  size_t const workers = std::max(static_cast<size_t>(1), static_cast<size_t>(std::thread::hardware_concurrency()));
+  for (size_t i = 0; i < workers; ++i)
   {
-    weight += WEIGHT_INVERSION;
-  } // if
+    std::thread(extraction_worker, std::ref(*pool)).detach();
+  } // for
+  extraction_pool_instance = pool;
+  return *pool;
+} // extraction_pool
 
+// Only used to interface to Python: queues an extraction on the pool.
+size_t extract_async(char_t const* const reference,
+                     size_t const        reference_length,
+                     char_t const* const sample,
+                     size_t const        sample_length,
+                     int const           type,
+                     char_t const* const codon_string,
+                     bool const          annotate)
+{
+  Extraction_Pool &pool = extraction_pool();
+  Extraction_Job job;
+  job.reference.assign(reference, reference_length);
+  job.sample.assign(sample, sample_length);
+  job.type = type;
+  job.codon_table = type == TYPE_PROTEIN ? get_codon_table(codon_string) : 0;
+  job.annotate = annotate;
+
+  std::unique_lock<std::mutex> lock(pool.mutex);
+  job.identifier = pool.next_identifier++;
+  pool.pending.insert(job.identifier);
+  pool.queue.push_back(std::move(job));
+  size_t const identifier = pool.queue.back().identifier;
+  lock.unlock();
+  pool.queued.notify_one();
+  return identifier;
+} // extract_async
+
+// Only used to interface to Python: the file descriptor signalling
+// completed extractions.
+int extraction_fd(void)
+{
+  return extraction_pool().signal[0];
+} // extraction_fd
 
-#if defined(__debug__)
-  fprintf(stderr, "  LCS (x%ld)\n", substring.size());
-  for (std::vector<Substring>::const_iterator it = substring.begin() ; it != substring.end(); ++it)
+// Only used to interface to Python: the extractions completed since
+// the previous call. The pipe is drained first, such that a later
+// completion is always signalled again.
+std::vector<size_t> completed_extractions(void)
+{
+  Extraction_Pool &pool = extraction_pool();
+  if (pool.signal[0] != -1)
   {
-    if (!it->reverse_complement)
-    {
-      fprintf(stderr, "    %ld--%ld: ", it->reference_index, it->reference_index + length);
-      Dprint_truncated(reference, it->reference_index, it->reference_index + length);
-      fprintf(stderr, " (%ld)\n    %ld--%ld: ", length, it->sample_index, it->sample_index + length);
-      Dprint_truncated(sample, it->sample_index, it->sample_index + length);
-      fprintf(stderr, " (%ld)", length);
-    } // if
-    else
+    char buffer[256];
+    while (read(pool.signal[0], buffer, sizeof(buffer)) > 0)
     {
-      fprintf(stderr, "    %ld--%ld: ", it->reference_index, it->reference_index + length);
-      Dprint_truncated(complement, it->reference_index, it->reference_index + length);
-      fprintf(stderr, " (%ld), (reverse complement)\n    %ld--%ld: ", length, it->sample_index, it->sample_index + length);
-      Dprint_truncated(sample, it->sample_index, it->sample_index + length);
-      fprintf(stderr, " (%ld)", length);
-    } // else
-    fputs("\n", stderr);
-  } // for
-#endif
-
+    } // while
+  } // if
 
-  // Recursively apply this function to the prefixes of the strings
-  std::vector<Variant> prefix;
-  weight += extractor_transposition(prefix, reference, complement, reference_start, reference_end, sample, sample_start, lcs->sample_index, lcs->sample_index - sample_start) + WEIGHT_SEPARATOR;
+  std::unique_lock<std::mutex> lock(pool.mutex);
+  std::vector<size_t> const completed(pool.completed.begin(), pool.completed.end());
+  pool.completed.clear();
+  return completed;
+} // completed_extractions
 
-  // Stop if the weight of the variant exeeds the trivial weight.
-  if (weight > weight_trivial)
+// Only used to interface to Python: checks whether an extraction is
+// completed.
+bool extraction_done(size_t const identifier)
+{
+  Extraction_Pool &pool = extraction_pool();
+  std::unique_lock<std::mutex> lock(pool.mutex);
+  return pool.result.count(identifier) > 0;
+} // extraction_done
+
+// Only used to interface to Python: waits for an extraction and takes
+// its result (or rethrows its exception). The issued identifiers are
+// either pending or have a result (also a failed extraction), until
+// the result is taken.
+Variant_List extraction_result(size_t const identifier)
+{
+  Extraction_Pool &pool = extraction_pool();
+  std::unique_lock<std::mutex> lock(pool.mutex);
+  pool.finished.wait(lock, [&pool, identifier]()
   {
-    weight = sample_length * WEIGHT_BASE;
-    variant.push_back(Variant(reference_start, reference_end, sample_start, sample_end, SUBSTITUTION, weight));
-    return weight;
-  } // if
-
-  // Recursively apply this function to the suffixes of the strings.
-  std::vector<Variant> suffix;
-  weight += extractor_transposition(suffix, reference, complement, reference_start, reference_end, sample, lcs->sample_index + length, sample_end, sample_end - (lcs->sample_index + length)) + WEIGHT_SEPARATOR;
+    return pool.pending.count(identifier) == 0;
+  });
 
-  // Stop if the weight of the variant exeeds the trivial weight.
-  if (weight > weight_trivial)
+  std::unordered_map<size_t, Variant_List>::iterator const it = pool.result.find(identifier);
+  if (it == pool.result.end())
   {
-    weight = sample_length * WEIGHT_BASE;
-    variant.push_back(Variant(reference_start, reference_end, sample_start, sample_end, SUBSTITUTION, weight));
-    return weight;
+    throw std::out_of_range("unknown extraction identifier (or its result is already taken)");
   } // if
+  Variant_List variant_list = std::move(it->second);
+  pool.result.erase(it);
+  pool.completed.erase(identifier);
 
-
-  // Add all variants (in order) to the variant vector.
-  variant.insert(variant.end(), prefix.begin(), prefix.end());
-
-  if (!lcs->reverse_complement)
+  std::unordered_map<size_t, std::exception_ptr>::iterator const failure = pool.failure.find(identifier);
+  if (failure != pool.failure.end())
   {
-    variant.push_back(Variant(reference_start, reference_end, lcs->sample_index, lcs->sample_index + length, IDENTITY, 2 * weight_position + WEIGHT_SEPARATOR, lcs->reference_index, lcs->reference_index + length));
+    std::exception_ptr const exception = failure->second;
+    pool.failure.erase(failure);
+    std::rethrow_exception(exception);
   } // if
-  else
+  return variant_list;
+} // extraction_result
+
+// This is the recursive extractor function. It works as follows:
+// First, determine the ``best fitting'' longest common substring
+// (LCS) (possibly as a reverse complement) and discard it from the
+// solution. Then apply the same function on the remaining prefixes
+// and suffixes. If there is no LCS it is a variant (region of
+// change), i.e., a deletion/insertion.
+// With regard to the reverse complement: the complement string is, as
+// its name suggests, just the complement (DNA/RNA) of the reference
+// string but it is NOT reversed.
+template <bool COMPLEMENT, bool MASKED>
+static size_t extractor(std::vector<Variant> &variant,
+                        char_t const* const   reference,
+                        char_t const* const   complement,
+                        size_t           reference_start,
+                        size_t           reference_end,
+                        char_t const* const   sample,
+                        size_t           sample_start,
+                        size_t           sample_end)
+{
+  // First do prefix and suffix matching on the MASK character (only
+  // if the strings can contain it).
+  if (MASKED)
   {
-    variant.push_back(Variant(reference_start, reference_end, lcs->sample_index, lcs->sample_index + length, REVERSE_COMPLEMENT, 2 * weight_position + WEIGHT_SEPARATOR + WEIGHT_INVERSION, lcs->reference_index, lcs->reference_index + length));
-  } // else
+    size_t i = 0;
+    while (reference_start + i < reference_end && reference[reference_start + i] == MASK)
+    {
+      ++i;
+    } // while
+    reference_start += i;
+    i = 0;
+    while (reference_end - i - 1 > reference_start && reference[reference_end - i - 1] == MASK)
+    {
+      ++i;
+    } // while
+    reference_end -= i;
 
-  variant.insert(variant.end(), suffix.begin(), suffix.end());
+    i = 0;
+    while (sample_start + i < sample_end && sample[sample_start + i] == MASK)
+    {
+      ++i;
+    } // while
+    sample_start += i;
+    i = 0;
+    while (sample_end - i - 1 > sample_start && sample[sample_end - i - 1] == MASK)
+    {
+      ++i;
+    } // while
+    sample_end -= i;
+  } // if
 
-  return weight;
-} // extractor_transposition
 
-// This is the recursive protein extractor function. It works as the
-// regular extractor function, but no reverse complements nor
-// transposion matching is used.
-size_t extractor_protein(std::vector<Variant> &variant,
-                         char_t const* const   reference,
-                         size_t const          reference_start,
-                         size_t const          reference_end,
-                         char_t const* const   sample,
-                         size_t const          sample_start,
-                         size_t const          sample_end)
-{
   size_t const reference_length = reference_end - reference_start;
   size_t const sample_length = sample_end - sample_start;
 
@@ -674,10 +1628,13 @@ size_t extractor_protein(std::vector<Variant> &variant,
 
 
 #if defined(__debug__)
-  fputs("Extraction (protein)\n", stderr);
+  fputs("Extraction\n", stderr);
   fprintf(stderr, "  reference %ld--%ld:  ", reference_start, reference_end);
   Dprint_truncated(reference, reference_start, reference_end);
   fprintf(stderr, " (%ld)\n", reference_length);
+  fprintf(stderr, "  complement %ld--%ld: ", reference_start, reference_end);
+  Dprint_truncated(complement, reference_start, reference_end);
+  fprintf(stderr, " (%ld)\n", reference_length);
   fprintf(stderr, "  sample %ld--%ld:     ", sample_start, sample_end);
   Dprint_truncated(sample, sample_start, sample_end);
   fprintf(stderr, " (%ld)\n", sample_length);
@@ -690,10 +1647,38 @@ size_t extractor_protein(std::vector<Variant> &variant,
   if (reference_length <= 0)
   {
     // But some of the sample string is remaining: this is an
-    // insertion.
+    // insertion or transposition.
     if (sample_length > 0)
     {
       weight = 2 * weight_position + WEIGHT_SEPARATOR + WEIGHT_INSERTION + WEIGHT_BASE * sample_length;
+
+      // First, we check if we can match the inserted substring
+      // somewhere in the complete reference string. This will
+      // indicate a possible transposition. Otherwise it is a regular
+      // insertion.
+      std::vector<Variant> transposition;
+      size_t const weight_transposition = extractor_transposition<COMPLEMENT, MASKED>(transposition, reference, complement, reference_start, reference_end, sample, sample_start, sample_end, weight) + 2 * weight_position + 3 * WEIGHT_SEPARATOR + WEIGHT_INSERTION;
+
+
+#if defined(__debug__)
+  fprintf(stderr, "Transpositions: %ld (trivial: %ld)\n", weight_transposition, weight);
+  for (std::vector<Variant>::const_iterator it = transposition.begin(); it != transposition.end(); ++it)
+  {
+    fprintf(stderr, "  %ld--%ld, %ld--%ld, %d, %ld, %ld--%ld\n", it->reference_start, it->reference_end, it->sample_start, it->sample_end, it->type, it->weight, it->transposition_start, it->transposition_end);
+  } // for
+#endif
+
+
+      // Add transpositions if any.
+      if (weight > weight_transposition && transposition.size() > 0 && !(transposition.size() == 1 && transposition.front().type == SUBSTITUTION))
+      {
+        transposition.front().type |= TRANSPOSITION_OPEN;
+        transposition.back().type |= TRANSPOSITION_CLOSE;
+        variant.insert(variant.end(), transposition.begin(), transposition.end());
+        return weight_transposition;
+      } // if
+
+      // This is an actual insertion.
       variant.push_back(Variant(reference_start, reference_end, sample_start, sample_end, SUBSTITUTION, weight));
     } // if
     return weight;
@@ -708,7 +1693,7 @@ size_t extractor_protein(std::vector<Variant> &variant,
     return weight;
   } // if
 
-  // Single substitution: a special case for HGVS.
+  // Single-nucleotide polymorphism (SNP): a special case for HGVS.
   if (reference_length == 1 && sample_length == 1)
   {
     weight = weight_position + 2 * WEIGHT_BASE + WEIGHT_SUBSTITUTION;
@@ -717,16 +1702,43 @@ size_t extractor_protein(std::vector<Variant> &variant,
   } // if
 
 
-  // Calculate the LCS of the two strings.
+  // Calculate the LCS (possibly in reverse complement) of the two
+  // strings.
+  size_t const cut_off = reference_length < THRESHOLD_CUT_OFF ? 1 : weight_position;
   std::vector<Substring> substring;
-  size_t const length = LCS_1(substring, reference, 0, reference_start, reference_end, sample, sample_start, sample_end);
+  size_t const length = LCS<COMPLEMENT, MASKED>(substring, reference, complement, reference_start, reference_end, sample, sample_start, sample_end, cut_off);
 
 
-  // No LCS found: this is a deletion/insertion.
+  // No LCS found: this is a transposition or a deletion/insertion.
   if (length <= 0 || substring.size() <= 0)
   {
     weight = weight_trivial;
 
+    // First, we check if we can match the inserted substring
+    // somewhere in the complete reference string. This will
+    // indicate a possible transposition.
+    std::vector<Variant> transposition;
+    size_t const weight_transposition = extractor_transposition<COMPLEMENT, MASKED>(transposition, reference, complement, reference_start, reference_end, sample, sample_start, sample_end, weight)  + 2 * weight_position + 3 * WEIGHT_SEPARATOR + WEIGHT_DELETION_INSERTION;
+
+
+#if defined(__debug__)
+  fprintf(stderr, "Transpositions: %ld (trivial: %ld)\n", weight_transposition, weight);
+  for (std::vector<Variant>::const_iterator it = transposition.begin(); it != transposition.end(); ++it)
+  {
+    fprintf(stderr, "  %ld--%ld, %ld--%ld, %d, %ld, %ld--%ld\n", it->reference_start, it->reference_end, it->sample_start, it->sample_end, it->type, it->weight, it->transposition_start, it->transposition_end);
+  } // for
+#endif
+
+
+    // Add transpositions if any.
+    if (weight > weight_transposition && transposition.size() > 0 && !(transposition.size() == 1 && transposition.front().type == SUBSTITUTION))
+    {
+      transposition.front().type |= TRANSPOSITION_OPEN;
+      transposition.back().type |= TRANSPOSITION_CLOSE;
+      variant.insert(variant.end(), transposition.begin(), transposition.end());
+      return weight_transposition;
+    } // if
+
     // This is an actual deletion/insertion.
     variant.push_back(Variant(reference_start, reference_end, sample_start, sample_end, SUBSTITUTION, weight_trivial));
     return weight_trivial;
@@ -750,28 +1762,71 @@ size_t extractor_protein(std::vector<Variant> &variant,
   } // for
 
 
-#if defined(__debug__)
-  fprintf(stderr, "  LCS (x%ld)\n", substring.size());
-  for (std::vector<Substring>::const_iterator it = substring.begin() ; it != substring.end(); ++it)
+  // Add some weight for reverse complement LCS.
+  if (lcs->reverse_complement)
   {
-    fprintf(stderr, "    %ld--%ld: ", it->reference_index, it->reference_index + length);
-    Dprint_truncated(reference, it->reference_index, it->reference_index + length);
-    fprintf(stderr, " (%ld)\n    %ld--%ld: ", length, it->sample_index, it->sample_index + length);
-    Dprint_truncated(sample, it->sample_index, it->sample_index + length);
-    fprintf(stderr, " (%ld)", length);
-    fputs("\n", stderr);
-  } // for
-#endif
-
+    weight = 2 * weight_position + WEIGHT_SEPARATOR + WEIGHT_INVERSION;
+  } // if
 
-  // Recursively apply this function to the prefixes of the strings.
-  std::vector<Variant> prefix;
-  weight += extractor_protein(prefix, reference, reference_start, lcs->reference_index, sample, sample_start, lcs->sample_index);
 
-  // Stop if the weight of the variant exeeds the trivial weight.
-  if (weight > weight_trivial)
+#if defined(__debug__)
+  fprintf(stderr, "  LCS (x%ld)\n", substring.size());
+  for (std::vector<Substring>::const_iterator it = substring.begin() ; it != substring.end(); ++it)
   {
-    weight = weight_trivial;
+    if (!it->reverse_complement)
+    {
+      fprintf(stderr, "    %ld--%ld: ", it->reference_index, it->reference_index + length);
+      Dprint_truncated(reference, it->reference_index, it->reference_index + length);
+      fprintf(stderr, " (%ld)\n    %ld--%ld: ", length, it->sample_index, it->sample_index + length);
+      Dprint_truncated(sample, it->sample_index, it->sample_index + length);
+      fprintf(stderr, " (%ld)", length);
+    } // if
+    else
+    {
+      fprintf(stderr, "    %ld--%ld: ", it->reference_index, it->reference_index + length);
+      Dprint_truncated(complement, it->reference_index, it->reference_index + length);
+      fprintf(stderr, " (%ld), (reverse complement)\n    %ld--%ld: ", length, it->sample_index, it->sample_index + length);
+      Dprint_truncated(sample, it->sample_index, it->sample_index + length);
+      fprintf(stderr, " (%ld)", length);
+    } // else
+    fputs("\n", stderr);
+  } // for
+#endif
+
+
+  // Recursively apply this function to the prefixes of the strings.
+  std::vector<Variant> prefix;
+  weight += extractor<COMPLEMENT, MASKED>(prefix, reference, complement, reference_start, lcs->reference_index, sample, sample_start, lcs->sample_index);
+
+  // Stop if the weight of the variant exeeds the trivial weight.
+  if (weight > weight_trivial)
+  {
+    weight = weight_trivial;
+
+    // First, we check if we can match the inserted substring
+    // somewhere in the complete reference string. This will
+    // indicate a possible transposition.
+    std::vector<Variant> transposition;
+    size_t const weight_transposition = extractor_transposition<COMPLEMENT, MASKED>(transposition, reference, complement, reference_start, reference_end, sample, sample_start, sample_end, weight)  + 2 * weight_position + 3 * WEIGHT_SEPARATOR + WEIGHT_DELETION_INSERTION;
+
+
+#if defined(__debug__)
+  fprintf(stderr, "Transpositions: %ld (trivial: %ld)\n", weight_transposition, weight);
+  for (std::vector<Variant>::const_iterator it = transposition.begin(); it != transposition.end(); ++it)
+  {
+    fprintf(stderr, "  %ld--%ld, %ld--%ld, %d, %ld, %ld--%ld\n", it->reference_start, it->reference_end, it->sample_start, it->sample_end, it->type, it->weight, it->transposition_start, it->transposition_end);
+  } // for
+#endif
+
+
+    // Add transpositions if any.
+    if (weight > weight_transposition && transposition.size() > 0 && !(transposition.size() == 1 && transposition.front().type == SUBSTITUTION))
+    {
+      transposition.front().type |= TRANSPOSITION_OPEN;
+      transposition.back().type |= TRANSPOSITION_CLOSE;
+      variant.insert(variant.end(), transposition.begin(), transposition.end());
+      return weight_transposition;
+    } // if
 
     // This is an actual deletion/insertion.
     variant.push_back(Variant(reference_start, reference_end, sample_start, sample_end, SUBSTITUTION, weight_trivial));
@@ -780,13 +1835,38 @@ size_t extractor_protein(std::vector<Variant> &variant,
 
   // Recursively apply this function to the suffixes of the strings.
   std::vector<Variant> suffix;
-  weight += extractor_protein(suffix, reference, lcs->reference_index + length, reference_end, sample, lcs->sample_index + length, sample_end);
+  weight += extractor<COMPLEMENT, MASKED>(suffix, reference, complement, lcs->reference_index + length, reference_end, sample, lcs->sample_index + length, sample_end);
 
   // Stop if the weight of the variant exeeds the trivial weight.
   if (weight > weight_trivial)
   {
     weight = weight_trivial;
 
+    // First, we check if we can match the inserted substring
+    // somewhere in the complete reference string. This will
+    // indicate a possible transposition.
+    std::vector<Variant> transposition;
+    size_t const weight_transposition = extractor_transposition<COMPLEMENT, MASKED>(transposition, reference, complement, reference_start, reference_end, sample, sample_start, sample_end, weight)  + 2 * weight_position + 3 * WEIGHT_SEPARATOR + WEIGHT_DELETION_INSERTION;
+
+
+#if defined(__debug__)
+  fprintf(stderr, "Transpositions: %ld (trivial: %ld)\n", weight_transposition, weight);
+  for (std::vector<Variant>::const_iterator it = transposition.begin(); it != transposition.end(); ++it)
+  {
+    fprintf(stderr, "  %ld--%ld, %ld--%ld, %d, %ld, %ld--%ld\n", it->reference_start, it->reference_end, it->sample_start, it->sample_end, it->type, it->weight, it->transposition_start, it->transposition_end);
+  } // for
+#endif
+
+
+    // Add transpositions if any.
+    if (weight > weight_transposition && transposition.size() > 0 && !(transposition.size() == 1 && transposition.front().type == SUBSTITUTION))
+    {
+      transposition.front().type |= TRANSPOSITION_OPEN;
+      transposition.back().type |= TRANSPOSITION_CLOSE;
+      variant.insert(variant.end(), transposition.begin(), transposition.end());
+      return weight_transposition;
+    } // if
+
     // This is an actual deletion/insertion.
     variant.push_back(Variant(reference_start, reference_end, sample_start, sample_end, SUBSTITUTION, weight_trivial));
     return weight_trivial;
@@ -795,320 +1875,1449 @@ size_t extractor_protein(std::vector<Variant> &variant,
 
   // Add all variants (in order) to the variant vector.
   variant.insert(variant.end(), prefix.begin(), prefix.end());
-  variant.push_back(Variant(lcs->reference_index, lcs->reference_index + length, lcs->sample_index, lcs->sample_index + length));
+
+  if (!lcs->reverse_complement)
+  {
+    variant.push_back(Variant(lcs->reference_index, lcs->reference_index + length, lcs->sample_index, lcs->sample_index + length));
+  } // if
+  else
+  {
+    variant.push_back(Variant(lcs->reference_index, lcs->reference_index + length, lcs->sample_index, lcs->sample_index + length, REVERSE_COMPLEMENT, 2 * weight_position + WEIGHT_SEPARATOR + WEIGHT_INVERSION));
+  } // else
+
   variant.insert(variant.end(), suffix.begin(), suffix.end());
 
   return weight;
-} // extractor_protein
+} // extractor
 
-void extractor_frame_shift(std::vector<Variant> &annotation,
-                           char_t const* const   reference,
-                           size_t const          reference_start,
-                           size_t const          reference_end,
-                           char_t const* const   sample,
-                           size_t const          sample_start,
-                           size_t const          sample_end)
+// The extractor function for arbitrary (possibly masked) strings with
+// or without a complement string.
+size_t extractor(std::vector<Variant> &variant,
+                 char_t const* const   reference,
+                 char_t const* const   complement,
+                 size_t           reference_start,
+                 size_t           reference_end,
+                 char_t const* const   sample,
+                 size_t           sample_start,
+                 size_t           sample_end)
+{
+  if (complement != 0)
+  {
+    return extractor<true, true>(variant, reference, complement, reference_start, reference_end, sample, sample_start, sample_end);
+  } // if
+  return extractor<false, true>(variant, reference, complement, reference_start, reference_end, sample, sample_start, sample_end);
+} // extractor
+
+// This function tries to extract transpositions from inserted
+// sequences (insertions or deletion/insertions). Again we use a
+// recursive method: extract the LCS and apply to the remaining prefix
+// and suffix.
+template <bool COMPLEMENT, bool MASKED>
+static size_t extractor_transposition(std::vector<Variant> &variant,
+                                      char_t const* const   reference,
+                                      char_t const* const   complement,
+                                      size_t const          reference_start,
+                                      size_t const          reference_end,
+                                      char_t const* const   sample,
+                                      size_t const          sample_start,
+                                      size_t const          sample_end,
+                                      size_t const          weight_trivial)
 {
-  size_t const reference_length = reference_end - reference_start;
   size_t const sample_length = sample_end - sample_start;
 
+  size_t weight = 0;
+
 
 #if defined(__debug__)
-  fputs("Extraction (frame shift)\n", stderr);
-  fprintf(stderr, "  reference %ld--%ld:  ", reference_start, reference_end);
-  Dprint_truncated(reference, reference_start, reference_end);
-  fprintf(stderr, " (%ld)\n", reference_length);
+  fputs("Transposition extraction\n", stderr);
+  fprintf(stderr, "  reference %ld--%ld:  ", 0ul, global_reference_length);
+  Dprint_truncated(reference, 0, global_reference_length);
+  fprintf(stderr, " (%ld)\n", global_reference_length);
+  fprintf(stderr, "  complement %ld--%ld: ", 0ul, global_reference_length);
+  Dprint_truncated(complement, 0, global_reference_length);
+  fprintf(stderr, " (%ld)\n", global_reference_length);
   fprintf(stderr, "  sample %ld--%ld:     ", sample_start, sample_end);
   Dprint_truncated(sample, sample_start, sample_end);
   fprintf(stderr, " (%ld)\n", sample_length);
+  fprintf(stderr, "  trivial weight: %ld\n", weight_trivial);
 #endif
 
 
-  // First the base cases to end the recursion.
-  if (reference_length <= 0 || sample_length <= 0)
+  // End transposition extraction if no more of the sample string
+  // remains.
+  if (sample_length <= 0)
   {
-    return;
+    return weight;
+  } // if
+
+
+  // Only consider large enough inserted regions (>> 1), based on
+  // (average) description length of a position, otherwise it is just
+  // a deletion/insertion.
+  if (sample_length <= 2 * weight_position)
+  {
+    weight = sample_length * WEIGHT_BASE;
+    variant.push_back(Variant(reference_start, reference_end, sample_start, sample_end, SUBSTITUTION, weight));
+    return weight;
+  } // if
+
+
+  // Extract the LCS (from the whole reference string).
+  size_t const cut_off = global_reference_length < THRESHOLD_CUT_OFF ? 1 : TRANSPOSITION_CUT_OFF * sample_length;
+  std::vector<Substring> substring;
+  size_t const length = LCS<COMPLEMENT, MASKED>(substring, reference, complement, 0, global_reference_length, sample, sample_start, sample_end, cut_off);
+
+
+  // No LCS found: this is a deletion/insertion.
+  if (length <= 0 || substring.size() <= 0)
+  {
+    weight = sample_length * WEIGHT_BASE;
+    variant.push_back(Variant(reference_start, reference_end, sample_start, sample_end, SUBSTITUTION, weight));
+    return weight;
+  } // if
+
+  // We do NOT have to bother about a ``best fitting'' LCS here.
+  std::vector<Substring>::const_iterator const lcs = substring.begin();
+
+  // Update the weight of the transposition.
+  weight += 2 * weight_position + WEIGHT_SEPARATOR;
+  if (lcs->reverse_complement)
+  {
+    weight += WEIGHT_INVERSION;
+  } // if
+
+
+#if defined(__debug__)
+  fprintf(stderr, "  LCS (x%ld)\n", substring.size());
+  for (std::vector<Substring>::const_iterator it = substring.begin() ; it != substring.end(); ++it)
+  {
+    if (!it->reverse_complement)
+    {
+      fprintf(stderr, "    %ld--%ld: ", it->reference_index, it->reference_index + length);
+      Dprint_truncated(reference, it->reference_index, it->reference_index + length);
+      fprintf(stderr, " (%ld)\n    %ld--%ld: ", length, it->sample_index, it->sample_index + length);
+      Dprint_truncated(sample, it->sample_index, it->sample_index + length);
+      fprintf(stderr, " (%ld)", length);
+    } // if
+    else
+    {
+      fprintf(stderr, "    %ld--%ld: ", it->reference_index, it->reference_index + length);
+      Dprint_truncated(complement, it->reference_index, it->reference_index + length);
+      fprintf(stderr, " (%ld), (reverse complement)\n    %ld--%ld: ", length, it->sample_index, it->sample_index + length);
+      Dprint_truncated(sample, it->sample_index, it->sample_index + length);
+      fprintf(stderr, " (%ld)", length);
+    } // else
+    fputs("\n", stderr);
+  } // for
+#endif
+
+
+  // Recursively apply this function to the prefixes of the strings
+  std::vector<Variant> prefix;
+  weight += extractor_transposition<COMPLEMENT, MASKED>(prefix, reference, complement, reference_start, reference_end, sample, sample_start, lcs->sample_index, lcs->sample_index - sample_start) + WEIGHT_SEPARATOR;
+
+  // Stop if the weight of the variant exeeds the trivial weight.
+  if (weight > weight_trivial)
+  {
+    weight = sample_length * WEIGHT_BASE;
+    variant.push_back(Variant(reference_start, reference_end, sample_start, sample_end, SUBSTITUTION, weight));
+    return weight;
+  } // if
+
+  // Recursively apply this function to the suffixes of the strings.
+  std::vector<Variant> suffix;
+  weight += extractor_transposition<COMPLEMENT, MASKED>(suffix, reference, complement, reference_start, reference_end, sample, lcs->sample_index + length, sample_end, sample_end - (lcs->sample_index + length)) + WEIGHT_SEPARATOR;
+
+  // Stop if the weight of the variant exeeds the trivial weight.
+  if (weight > weight_trivial)
+  {
+    weight = sample_length * WEIGHT_BASE;
+    variant.push_back(Variant(reference_start, reference_end, sample_start, sample_end, SUBSTITUTION, weight));
+    return weight;
+  } // if
+
+
+  // Add all variants (in order) to the variant vector.
+  variant.insert(variant.end(), prefix.begin(), prefix.end());
+
+  if (!lcs->reverse_complement)
+  {
+    variant.push_back(Variant(reference_start, reference_end, lcs->sample_index, lcs->sample_index + length, IDENTITY, 2 * weight_position + WEIGHT_SEPARATOR, lcs->reference_index, lcs->reference_index + length));
+  } // if
+  else
+  {
+    variant.push_back(Variant(reference_start, reference_end, lcs->sample_index, lcs->sample_index + length, REVERSE_COMPLEMENT, 2 * weight_position + WEIGHT_SEPARATOR + WEIGHT_INVERSION, lcs->reference_index, lcs->reference_index + length));
+  } // else
+
+  variant.insert(variant.end(), suffix.begin(), suffix.end());
+
+  return weight;
+} // extractor_transposition
+
+// The transposition extractor function for arbitrary (possibly
+// masked) strings with or without a complement string.
+size_t extractor_transposition(std::vector<Variant> &variant,
+                               char_t const* const   reference,
+                               char_t const* const   complement,
+                               size_t const          reference_start,
+                               size_t const          reference_end,
+                               char_t const* const   sample,
+                               size_t const          sample_start,
+                               size_t const          sample_end,
+                               size_t const          weight_trivial)
+{
+  if (complement != 0)
+  {
+    return extractor_transposition<true, true>(variant, reference, complement, reference_start, reference_end, sample, sample_start, sample_end, weight_trivial);
   } // if
+  return extractor_transposition<false, true>(variant, reference, complement, reference_start, reference_end, sample, sample_start, sample_end, weight_trivial);
+} // extractor_transposition
+
+// This is the recursive protein extractor function. It works as the
+// regular extractor function, but no reverse complements nor
+// transposion matching is used.
+template <bool MASKED>
+static size_t extractor_protein(std::vector<Variant> &variant,
+                                char_t const* const   reference,
+                                size_t const          reference_start,
+                                size_t const          reference_end,
+                                char_t const* const   sample,
+                                size_t const          sample_start,
+                                size_t const          sample_end)
+{
+  size_t const reference_length = reference_end - reference_start;
+  size_t const sample_length = sample_end - sample_start;
 
+  // Assume this is a deletion/insertion.
+  size_t const weight_trivial = weight_position + WEIGHT_DELETION_INSERTION + WEIGHT_BASE * sample_length + (reference_length != 1 ? weight_position + WEIGHT_SEPARATOR : 0);
+  size_t weight = 0;
+
+
+#if defined(__debug__)
+  fputs("Extraction (protein)\n", stderr);
+  fprintf(stderr, "  reference %ld--%ld:  ", reference_start, reference_end);
+  Dprint_truncated(reference, reference_start, reference_end);
+  fprintf(stderr, " (%ld)\n", reference_length);
+  fprintf(stderr, "  sample %ld--%ld:     ", sample_start, sample_end);
+  Dprint_truncated(sample, sample_start, sample_end);
+  fprintf(stderr, " (%ld)\n", sample_length);
+  fprintf(stderr, "  trivial weight: %ld\n", weight_trivial);
+#endif
+
+
+  // First some base cases to end the recursion.
+  // No more reference string.
+  if (reference_length <= 0)
+  {
+    // But some of the sample string is remaining: this is an
+    // insertion.
+    if (sample_length > 0)
+    {
+      weight = 2 * weight_position + WEIGHT_SEPARATOR + WEIGHT_INSERTION + WEIGHT_BASE * sample_length;
+      variant.push_back(Variant(reference_start, reference_end, sample_start, sample_end, SUBSTITUTION, weight));
+    } // if
+    return weight;
+  } // if
+
+  // Obviously there is a piece of reference string left, but no more
+  // sample string: this is a deletion.
+  if (sample_length <= 0)
+  {
+    weight = weight_position + WEIGHT_DELETION + (reference_length > 1 ? weight_position + WEIGHT_SEPARATOR : 0);
+    variant.push_back(Variant(reference_start, reference_end, sample_start, sample_end, SUBSTITUTION, weight));
+    return weight;
+  } // if
+
+  // Single substitution: a special case for HGVS.
+  if (reference_length == 1 && sample_length == 1)
+  {
+    weight = weight_position + 2 * WEIGHT_BASE + WEIGHT_SUBSTITUTION;
+    variant.push_back(Variant(reference_start, reference_end, sample_start, sample_end, SUBSTITUTION, weight));
+    return weight;
+  } // if
+
+
+  // Calculate the LCS of the two strings.
+  std::vector<Substring> substring;
+  size_t const length = LCS_1<false, MASKED>(substring, reference, 0, reference_start, reference_end, sample, sample_start, sample_end);
+
+
+  // No LCS found: this is a deletion/insertion.
+  if (length <= 0 || substring.size() <= 0)
+  {
+    weight = weight_trivial;
+
+    // This is an actual deletion/insertion.
+    variant.push_back(Variant(reference_start, reference_end, sample_start, sample_end, SUBSTITUTION, weight_trivial));
+    return weight_trivial;
+  } // if
+
+
+  // Pick the ``best fitting'' LCS, i.e., the remaining prefixes and
+  // suffixes are of the same length.
+  size_t diff = (reference_end - reference_start) + (sample_end - sample_start);
+  std::vector<Substring>::const_iterator lcs = substring.begin();
+  for (std::vector<Substring>::const_iterator it = substring.begin(); it != substring.end(); ++it)
+  {
+    size_t const prefix_diff = abs((it->reference_index - reference_start) - (it->sample_index - sample_start));
+    size_t const suffix_diff = abs((reference_end - (it->reference_index + it->length)) - (sample_end - (it->sample_index + it->length)));
+    if (prefix_diff + suffix_diff < diff)
+    {
+      // A better fitting LCS.
+      diff = prefix_diff + suffix_diff;
+      lcs = it;
+    } // if
+  } // for
+
+
+#if defined(__debug__)
+  fprintf(stderr, "  LCS (x%ld)\n", substring.size());
+  for (std::vector<Substring>::const_iterator it = substring.begin() ; it != substring.end(); ++it)
+  {
+    fprintf(stderr, "    %ld--%ld: ", it->reference_index, it->reference_index + length);
+    Dprint_truncated(reference, it->reference_index, it->reference_index + length);
+    fprintf(stderr, " (%ld)\n    %ld--%ld: ", length, it->sample_index, it->sample_index + length);
+    Dprint_truncated(sample, it->sample_index, it->sample_index + length);
+    fprintf(stderr, " (%ld)", length);
+    fputs("\n", stderr);
+  } // for
+#endif
+
+
+  // Recursively apply this function to the prefixes of the strings.
+  std::vector<Variant> prefix;
+  weight += extractor_protein<MASKED>(prefix, reference, reference_start, lcs->reference_index, sample, sample_start, lcs->sample_index);
+
+  // Stop if the weight of the variant exeeds the trivial weight.
+  if (weight > weight_trivial)
+  {
+    weight = weight_trivial;
+
+    // This is an actual deletion/insertion.
+    variant.push_back(Variant(reference_start, reference_end, sample_start, sample_end, SUBSTITUTION, weight_trivial));
+    return weight_trivial;
+  } // if
+
+  // Recursively apply this function to the suffixes of the strings.
+  std::vector<Variant> suffix;
+  weight += extractor_protein<MASKED>(suffix, reference, lcs->reference_index + length, reference_end, sample, lcs->sample_index + length, sample_end);
+
+  // Stop if the weight of the variant exeeds the trivial weight.
+  if (weight > weight_trivial)
+  {
+    weight = weight_trivial;
+
+    // This is an actual deletion/insertion.
+    variant.push_back(Variant(reference_start, reference_end, sample_start, sample_end, SUBSTITUTION, weight_trivial));
+    return weight_trivial;
+  } // if
+
+
+  // Add all variants (in order) to the variant vector.
+  variant.insert(variant.end(), prefix.begin(), prefix.end());
+  variant.push_back(Variant(lcs->reference_index, lcs->reference_index + length, lcs->sample_index, lcs->sample_index + length));
+  variant.insert(variant.end(), suffix.begin(), suffix.end());
+
+  return weight;
+} // extractor_protein
+
+// The protein extractor function for arbitrary (possibly masked)
+// strings.
+size_t extractor_protein(std::vector<Variant> &variant,
+                         char_t const* const   reference,
+                         size_t const          reference_start,
+                         size_t const          reference_end,
+                         char_t const* const   sample,
+                         size_t const          sample_start,
+                         size_t const          sample_end)
+{
+  return extractor_protein<true>(variant, reference, reference_start, reference_end, sample, sample_start, sample_end);
+} // extractor_protein
+
+// Clips a frame shifted run (see LCS_frame_shift_runs) to the part
+// that lies within the given ranges. The last reference position is
+// never part of a run. Returns an empty substring if nothing remains.
+static Substring clip_frame_shift_run(Substring const& run,
+                                      size_t const     reference_start,
+                                      size_t const     reference_end,
+                                      size_t const     sample_start,
+                                      size_t const     sample_end)
+{
+  if (reference_end <= reference_start + 1 || sample_end <= sample_start)
+  {
+    return Substring();
+  } // if
+  size_t const last = reference_end - 1;
+
+  size_t low = sample_start > run.sample_index ? sample_start - run.sample_index : 0;
+  size_t high = sample_end > run.sample_index ? sample_end - run.sample_index : 0;
+  if (run.type == FRAME_SHIFT_1 || run.type == FRAME_SHIFT_2)
+  {
+    low = std::max(low, reference_start > run.reference_index ? reference_start - run.reference_index : 0);
+    high = std::min(high, last > run.reference_index ? last - run.reference_index : 0);
+    high = std::min(high, static_cast<size_t>(run.length));
+    if (high <= low)
+    {
+      return Substring();
+    } // if
+    return Substring(run.reference_index + low, run.sample_index + low, high - low, run.type);
+  } // if
+
+  size_t const end = run.reference_index + run.length;
+  low = std::max(low, end > last ? end - last : 0);
+  high = std::min(high, end > reference_start ? end - reference_start : 0);
+  high = std::min(high, static_cast<size_t>(run.length));
+  if (high <= low)
+  {
+    return Substring();
+  } // if
+  return Substring(end - high, run.sample_index + low, high - low, run.type);
+} // clip_frame_shift_run
+
+// The recursion of the extractor_frame_shift function on the frame
+// shifted runs within the given ranges.
+static void extractor_frame_shift_runs(std::vector<Variant>         &annotation,
+                                       std::vector<Substring> const &run,
+                                       char_t const* const           reference,
+                                       size_t const                  reference_start,
+                                       size_t const                  reference_end,
+                                       char_t const* const           sample,
+                                       size_t const                  sample_start,
+                                       size_t const                  sample_end,
+                                       Codon_Table const&            codon_table,
+                                       double const* const           log_probability)
+{
+  size_t const reference_length = reference_end - reference_start;
+  size_t const sample_length = sample_end - sample_start;
+
+
+#if defined(__debug__)
+  fputs("Extraction (frame shift)\n", stderr);
+  fprintf(stderr, "  reference %ld--%ld:  ", reference_start, reference_end);
+  Dprint_truncated(reference, reference_start, reference_end);
+  fprintf(stderr, " (%ld)\n", reference_length);
+  fprintf(stderr, "  sample %ld--%ld:     ", sample_start, sample_end);
+  Dprint_truncated(sample, sample_start, sample_end);
+  fprintf(stderr, " (%ld)\n", sample_length);
+#endif
+
+
+  // First the base cases to end the recursion.
+  if (reference_length <= 0 || sample_length <= 0)
+  {
+    return;
+  } // if
+
+
+  // Calculate the frame shift LCS of the two strings from the frame
+  // shifted runs.
+  std::vector<Substring> substring;
+  LCS_frame_shift_clipped(substring, run, reference, reference_start, reference_end, sample, sample_start, sample_end, codon_table);
+
+
+  // Pick the ``best fitting'' frame shift LCS, i.e., pushed as far to
+  // the start of the reference string as possible. Also update in
+  // case of compound frame shifts.
+  Substring lcs(0, 0, 0, FRAME_SHIFT_NONE);
+  for (size_t i = 0; i < 5; ++i)
+  {
+    if (substring[i].length > lcs.length ||
+        (substring[i].length == lcs.length && substring[i].reference_index < lcs.reference_index))
+    {
+      lcs = substring[i];
+    } // if
+    // Update compound frame shifts, e.g.,
+    // FRAME_SHIFT_1 | FRAME_SHIFT_2
+    else if (substring[i].length == lcs.length &&
+             substring[i].reference_index == lcs.reference_index &&
+             substring[i].sample_index == lcs.sample_index)
+    {
+      lcs.type |= substring[i].type;
+    } // if
+  } // for
+
+
+  // No LCS found: no frame shift annotation.
+  if (lcs.length <= 0)
+  {
+    return;
+  } // if
+
+
+#if defined(__debug__)
+  fprintf(stderr, "  LCS type = %d\n", lcs.type);
+  fprintf(stderr, "    %ld--%ld: ", lcs.reference_index, lcs.reference_index + lcs.length);
+  Dprint_truncated(reference, lcs.reference_index, lcs.reference_index + lcs.length);
+  fprintf(stderr, " (%ld)\n    %ld--%ld: ", lcs.length, lcs.sample_index, lcs.sample_index + lcs.length);
+  Dprint_truncated(sample, lcs.sample_index, lcs.sample_index + lcs.length);
+  fprintf(stderr, " (%ld)", lcs.length);
+  fputs("\n", stderr);
+#endif
+
+
+  // Calculate the frame shift probability. A single frame shift is
+  // looked up in the prefix sums, compound frame shifts are
+  // calculated position by position.
+  double probability = 1.f;
+  if ((lcs.type & (lcs.type - 1)) == 0)
+  {
+    size_t const c = __builtin_ctz(lcs.type);
+    probability = exp(log_probability[5 * (lcs.reference_index + lcs.length) + c] - log_probability[5 * lcs.reference_index + c]);
+  } // if
+  else
+  {
+    for (size_t i = 0; i < lcs.length; ++i)
+    {
+      float const (&frequency)[5] = codon_table.frame_shift_frequency[codon_table.acid_code[reference[lcs.reference_index + i] & 0x7f]][codon_table.acid_code[reference[lcs.reference_index + i + 1] & 0x7f]];
+      float const (&frequency_reverse)[5] = codon_table.frame_shift_frequency[codon_table.acid_code[reference[lcs.reference_index + i] & 0x7f]][codon_table.acid_code[reference[lcs.reference_index + i] & 0x7f]];
+      double probability_compound = .0f;
+      if ((lcs.type & FRAME_SHIFT_1) == FRAME_SHIFT_1)
+      {
+        probability_compound += frequency[0];
+      } // if
+      if ((lcs.type & FRAME_SHIFT_2) == FRAME_SHIFT_2)
+      {
+        probability_compound += frequency[1];
+      } // if
+      if ((lcs.type & FRAME_SHIFT_REVERSE) == FRAME_SHIFT_REVERSE)
+      {
+        probability_compound += frequency_reverse[2];
+      } // if
+      if ((lcs.type & FRAME_SHIFT_REVERSE_1) == FRAME_SHIFT_REVERSE_1)
+      {
+        probability_compound += frequency[3];
+      } // if
+      if ((lcs.type & FRAME_SHIFT_REVERSE_2) == FRAME_SHIFT_REVERSE_2)
+      {
+        probability_compound += frequency[4];
+      } // if
+      probability *= probability_compound;
+    } // for
+  } // else
+
+
+  // Divide the frame shifted runs over the prefixes and the suffixes
+  // of the strings (a forward run may end up in both). Runs shorter
+  // than FRAME_SHIFT_RUN_LENGTH are not kept.
+  std::vector<Substring> prefix_run;
+  std::vector<Substring> suffix_run;
+  for (std::vector<Substring>::const_iterator it = run.begin(); it != run.end(); ++it)
+  {
+    Substring const prefix_clip = clip_frame_shift_run(*it, reference_start, lcs.reference_index, sample_start, lcs.sample_index);
+    if (prefix_clip.length >= FRAME_SHIFT_RUN_LENGTH)
+    {
+      prefix_run.push_back(prefix_clip);
+    } // if
+    Substring const suffix_clip = clip_frame_shift_run(*it, lcs.reference_index + lcs.length, reference_end, lcs.sample_index + lcs.length, sample_end);
+    if (suffix_clip.length >= FRAME_SHIFT_RUN_LENGTH)
+    {
+      suffix_run.push_back(suffix_clip);
+    } // if
+  } // for
+
+
+  // Recursively apply this function to the prefixes of the strings.
+  std::vector<Variant> prefix;
+  extractor_frame_shift_runs(prefix, prefix_run, reference, reference_start, lcs.reference_index, sample, sample_start, lcs.sample_index, codon_table, log_probability);
+
+
+  // Recursively apply this function to the suffixes of the strings.
+  std::vector<Variant> suffix;
+  extractor_frame_shift_runs(suffix, suffix_run, reference, lcs.reference_index + lcs.length, reference_end, sample, lcs.sample_index + lcs.length, sample_end, codon_table, log_probability);
+
+
+  // Add all variants (in order) to the annotation vector.
+  annotation.insert(annotation.end(), prefix.begin(), prefix.end());
+  Variant variant(lcs.reference_index, lcs.reference_index + lcs.length, lcs.sample_index, lcs.sample_index + lcs.length, FRAME_SHIFT | lcs.type);
+  variant.probability = probability;
+  annotation.push_back(variant);
+  annotation.insert(annotation.end(), suffix.begin(), suffix.end());
+
+  return;
+} // extractor_frame_shift_runs
+
+// The frame shift LCS matrix is calculated only once: all recursion
+// levels are answered from its frame shifted runs.
+void extractor_frame_shift(std::vector<Variant> &annotation,
+                           char_t const* const   reference,
+                           size_t const          reference_start,
+                           size_t const          reference_end,
+                           char_t const* const   sample,
+                           size_t const          sample_start,
+                           size_t const          sample_end,
+                           Codon_Table const&    codon_table,
+                           double const* const   log_probability)
+{
+  if (reference_end <= reference_start || sample_end <= sample_start)
+  {
+    return;
+  } // if
+
+  std::vector<Substring> run;
+  LCS_frame_shift_runs(run, reference, reference_start, reference_end, sample, sample_start, sample_end, codon_table);
+  extractor_frame_shift_runs(annotation, run, reference, reference_start, reference_end, sample, sample_start, sample_end, codon_table, log_probability);
+  return;
+} // extractor_frame_shift
+
+// This function calculates the LCS using the LCS_k function by
+// choosing an initial k and reducing it if necessary until the
+// strings represent random strings modeled by a threshold value.
+template <bool COMPLEMENT, bool MASKED>
+static size_t LCS(std::vector<Substring> &substring,
+                  char_t const* const     reference,
+                  char_t const* const     complement,
+                  size_t const            reference_start,
+                  size_t const            reference_end,
+                  char_t const* const     sample,
+                  size_t const            sample_start,
+                  size_t const            sample_end,
+                  size_t const            cut_off)
+{
+  size_t const reference_length = reference_end - reference_start;
+  size_t const sample_length = sample_end - sample_start;
+
+
+  // The initial k.
+  size_t k = reference_length > sample_length ? sample_length / 8 : reference_length / 8;
+
+
+  // Reduce k until the cut-off is reached.
+  while (k > 8 && k > cut_off)
+  {
+
+
+#if defined(__debug__)
+  fprintf(stderr, "  k = %ld (cut-off: %ld)\n", k, cut_off);
+#endif
+
+
+    // Try to find a LCS with k.
+    substring.clear();
+    size_t const length = LCS_k<COMPLEMENT, MASKED>(substring, reference, complement, reference_start, reference_end, sample, sample_start, sample_end, k);
+
+    // A LCS of sufficient length has been found.
+    if (length >= 2 * k && substring.size() > 0)
+    {
+      return length;
+    } // if
+    k /= 3;
+  } // while
+
+  // Cut-off: no LCS found.
+  if (cut_off > 1)
+  {
+
+
+#if defined(__debug__)
+  fprintf(stderr, "  cut-off\n");
+#endif
+
+
+    substring.clear();
+    return 0;
+  } // if
+
+
+#if defined(__debug__)
+  fprintf(stderr, "  k = 1\n");
+#endif
+
+
+  // As a last resort try running the classical algorithm.
+  return LCS_1<COMPLEMENT, MASKED>(substring, reference, complement, reference_start, reference_end, sample, sample_start, sample_end);
+} // LCS
+
+// The LCS function for arbitrary (possibly masked) strings with or
+// without a complement string.
+size_t LCS(std::vector<Substring> &substring,
+           char_t const* const     reference,
+           char_t const* const     complement,
+           size_t const            reference_start,
+           size_t const            reference_end,
+           char_t const* const     sample,
+           size_t const            sample_start,
+           size_t const            sample_end,
+           size_t const            cut_off)
+{
+  if (complement != 0)
+  {
+    return LCS<true, true>(substring, reference, complement, reference_start, reference_end, sample, sample_start, sample_end, cut_off);
+  } // if
+  return LCS<false, true>(substring, reference, complement, reference_start, reference_end, sample, sample_start, sample_end, cut_off);
+} // LCS
+
+// Counts the number of matching pairs of characters (i.e., the number
+// of matches in the dynamic programming matrix of LCS_1) using the
+// character frequencies of both strings.
+static size_t match_count(char_t const* const reference,
+                          size_t const        reference_start,
+                          size_t const        reference_end,
+                          char_t const* const sample,
+                          size_t const        sample_start,
+                          size_t const        sample_end)
+{
+  size_t frequency[256] = {0};
+  for (size_t j = reference_start; j < reference_end; ++j)
+  {
+    ++frequency[static_cast<uint8_t>(reference[j])];
+  } // for
+  frequency[static_cast<uint8_t>(MASK)] = 0;
+
+  size_t count = 0;
+  for (size_t i = sample_start; i < sample_end; ++i)
+  {
+    count += frequency[static_cast<uint8_t>(sample[i])];
+  } // for
+  return count;
+} // match_count
+
+// Counts the number of distinct characters (i.e., the alphabet size)
+// of a string.
+static size_t symbol_count(char_t const* const string,
+                           size_t const        start,
+                           size_t const        end)
+{
+  bool present[256] = {false};
+  size_t count = 0;
+  for (size_t i = start; i < end; ++i)
+  {
+    uint8_t const c = static_cast<uint8_t>(string[i]);
+    if (!present[c])
+    {
+      present[c] = true;
+      ++count;
+    } // if
+  } // for
+  return count;
+} // symbol_count
+
+// Calculate the LCS in the well-known way using dynamic programming.
+// NOT suitable for large strings.
+template <bool COMPLEMENT, bool MASKED>
+static size_t LCS_1(std::vector<Substring> &substring,
+                    char_t const* const     reference,
+                    char_t const* const     complement,
+                    size_t const            reference_start,
+                    size_t const            reference_end,
+                    char_t const* const     sample,
+                    size_t const            sample_start,
+                    size_t const            sample_end)
+{
+  // DNA/RNA strings (with a complement string) have a very small
+  // alphabet: use the bit-parallel version instead.
+  if (COMPLEMENT)
+  {
+    return LCS_1_bit_parallel(substring, reference, complement, reference_start, reference_end, sample, sample_start, sample_end);
+  } // if
+
+  size_t const reference_length = reference_end - reference_start;
+  size_t const sample_length = sample_end - sample_start;
+  bool reverse_complement = false;
+
+  // Large alphabets with only a few matches: visit only the matches.
+  // Large strings with a small alphabet (e.g., long proteins): use the
+  // linear time version, unless the matches are also few compared to
+  // the size of its transition table (e.g., a short sample string).
+  size_t const cells = reference_length * sample_length;
+  if (cells >= LCS_SPARSE_THRESHOLD)
+  {
+    size_t const matches = match_count(reference, reference_start, reference_end, sample, sample_start, sample_end);
+    size_t const symbols = cells > LCS_SUFFIX_AUTOMATON_THRESHOLD && reference_length < LCS_SUFFIX_AUTOMATON_LENGTH ? symbol_count(reference, reference_start, reference_end) : 0;
+    bool const automaton = symbols > 0 && symbols <= LCS_SUFFIX_AUTOMATON_SYMBOLS;
+
+    if (LCS_SPARSE_DENSITY * matches < cells && (!automaton || LCS_SPARSE_DENSITY * matches < 2 * reference_length * symbols))
+    {
+      return LCS_1_sparse(substring, reference, reference_start, reference_end, sample, sample_start, sample_end);
+    } // if
+    if (automaton)
+    {
+      return LCS_suffix_automaton(substring, reference, reference_start, reference_end, sample, sample_start, sample_end);
+    } // if
+  } // if
+
+  // Just a fancy way of allocation a continuous 2D array in heap
+  // space.
+  typedef position_t array[2][reference_length];
+  array &LCS_line = *(reinterpret_cast<array*>(new position_t[2 * reference_length]));
+  array &LCS_line_rc = *(reinterpret_cast<array*>(new position_t[2 * reference_length]));
+
+  size_t length = 0;
+
+  // Filling the LCS matrix (actually only the current and the
+  // previous row).
+  for (size_t i = 0; i < sample_length; ++i)
+  {
+    for (size_t j = 0; j < reference_length; ++j)
+    {
+      // A match
+      if (reference[reference_start + j] == sample[sample_start + i] && unmasked<MASKED>(reference[reference_start + j]))
+      {
+        if (i == 0 || j == 0)
+        {
+          LCS_line[i % 2][j] = 1;
+        } // if
+        else
+        {
+          LCS_line[i % 2][j] = LCS_line[(i + 1) % 2][j - 1] + 1;
+        } // else
+
+        // Check for a new maximal length.
+        if (LCS_line[i % 2][j] >= length)
+        {
+          if (reverse_complement || LCS_line[i % 2][j] > length)
+          {
+            length = LCS_line[i % 2][j];
+            substring = std::vector<Substring>(1, Substring(j - length + reference_start + 1, i - length + sample_start + 1, length));
+          } // if
+          else
+          {
+            substring.push_back(Substring(j - length + reference_start + 1, i - length + sample_start + 1, length));
+          } // else
+          reverse_complement = false;
+        } // if
+      } // if
+      else
+      {
+        LCS_line[i % 2][j] = 0;
+      } // else
+
+      // If applicable check for a LCS in reverse complement space.
+      // The same code is used as before but the complement string is
+      // travesed backwards (towards the start).
+      if (COMPLEMENT && complement[reference_end - j - 1] == sample[sample_start + i] && unmasked<MASKED>(complement[reference_end - j - 1]))
+      {
+        if (i == 0 || j == 0)
+        {
+          LCS_line_rc[i % 2][j] = 1;
+        } // if
+        else
+        {
+          LCS_line_rc[i % 2][j] = LCS_line_rc[(i + 1) % 2][j - 1] + 1;
+        } // else
+
+        if (LCS_line_rc[i % 2][j] > 1 && LCS_line_rc[i % 2][j] > length)
+        {
+          length = LCS_line_rc[i % 2][j];
+          substring = std::vector<Substring>(1, Substring(reference_end - j - 1, i - length + sample_start + 1, length, true));
+          reverse_complement = true;
+        } // if
+      } // if
+      else
+      {
+        LCS_line_rc[i % 2][j] = 0;
+      } // else
+
+
+      // We can stop if the whole sample string is part of the LCS.
+      if (!reverse_complement && length >= sample_length)
+      {
+        break;
+      } // if
+
+    } // for
+  } // for
+
+  // Cleaning up.
+  delete[] &LCS_line;
+  delete[] &LCS_line_rc;
+
+  return length;
+} // LCS_1
+
+// The LCS_1 function for arbitrary (possibly masked) strings with or
+// without a complement string.
+size_t LCS_1(std::vector<Substring> &substring,
+             char_t const* const     reference,
+             char_t const* const     complement,
+             size_t const            reference_start,
+             size_t const            reference_end,
+             char_t const* const     sample,
+             size_t const            sample_start,
+             size_t const            sample_end)
+{
+  if (complement != 0)
+  {
+    return LCS_1<true, true>(substring, reference, complement, reference_start, reference_end, sample, sample_start, sample_end);
+  } // if
+  return LCS_1<false, true>(substring, reference, complement, reference_start, reference_end, sample, sample_start, sample_end);
+} // LCS_1
+
+// Calculate the LCS with the same recurrence as LCS_1, but visit only
+// the matching cells. The occurrences of every character in the
+// reference are listed in advance and the length of the current match
+// is kept per diagonal. The cells are visited in the same order as
+// LCS_1 to keep the same tie-breaking.
+size_t LCS_1_sparse(std::vector<Substring> &substring,
+                    char_t const* const     reference,
+                    size_t const            reference_start,
+                    size_t const            reference_end,
+                    char_t const* const     sample,
+                    size_t const            sample_start,
+                    size_t const            sample_end)
+{
+  size_t const reference_length = reference_end - reference_start;
+  size_t const sample_length = sample_end - sample_start;
+
+  // The occurrence lists (in order) of all characters in the
+  // reference string (the MASK character never matches).
+  size_t occurrence_start[257] = {0};
+  for (size_t j = 0; j < reference_length; ++j)
+  {
+    ++occurrence_start[static_cast<uint8_t>(reference[reference_start + j]) + 1];
+  } // for
+  for (size_t c = 0; c < 256; ++c)
+  {
+    occurrence_start[c + 1] += occurrence_start[c];
+  } // for
+  size_t* const occurrence = new size_t[reference_length];
+  {
+    size_t fill[256];
+    for (size_t c = 0; c < 256; ++c)
+    {
+      fill[c] = occurrence_start[c];
+    } // for
+    for (size_t j = 0; j < reference_length; ++j)
+    {
+      occurrence[fill[static_cast<uint8_t>(reference[reference_start + j])]++] = j;
+    } // for
+  }
 
-  // Calculate the frame shift LCS of the two strings.
-  std::vector<Substring> substring;
-  LCS_frame_shift(substring, reference, reference_start, reference_end, sample, sample_start, sample_end);
+  // The length of the match on every diagonal (j - i) and the row in
+  // which it was last extended.
+  size_t* const diagonal_length = new size_t[reference_length + sample_length];
+  size_t* const diagonal_row = new size_t[reference_length + sample_length];
+  for (size_t d = 0; d < reference_length + sample_length; ++d)
+  {
+    diagonal_row[d] = static_cast<size_t>(-1);
+  } // for
 
+  size_t length = 0;
 
-  // Pick the ``best fitting'' frame shift LCS, i.e., pushed as far to
-  // the start of the reference string as possible. Also update in
-  // case of compound frame shifts.
-  Substring lcs(0, 0, 0, FRAME_SHIFT_NONE);
-  for (size_t i = 0; i < 5; ++i)
+  for (size_t i = 0; i < sample_length; ++i)
   {
-    if (substring[i].length > lcs.length ||
-        (substring[i].length == lcs.length && substring[i].reference_index < lcs.reference_index))
+    uint8_t const c = static_cast<uint8_t>(sample[sample_start + i]);
+    if (c == static_cast<uint8_t>(MASK))
     {
-      lcs = substring[i];
+      continue;
     } // if
-    // Update compound frame shifts, e.g.,
-    // FRAME_SHIFT_1 | FRAME_SHIFT_2
-    else if (substring[i].length == lcs.length &&
-             substring[i].reference_index == lcs.reference_index &&
-             substring[i].sample_index == lcs.sample_index)
+    for (size_t k = occurrence_start[c]; k < occurrence_start[c + 1]; ++k)
     {
-      lcs.type |= substring[i].type;
-    } // if
+      size_t const j = occurrence[k];
+      size_t const d = j + sample_length - 1 - i;
+      size_t const current = (i > 0 && diagonal_row[d] == i - 1) ? diagonal_length[d] + 1 : 1;
+      diagonal_length[d] = current;
+      diagonal_row[d] = i;
+
+      // Check for a new maximal length.
+      if (current >= length)
+      {
+        if (current > length)
+        {
+          length = current;
+          substring = std::vector<Substring>(1, Substring(j - length + reference_start + 1, i - length + sample_start + 1, length));
+        } // if
+        else
+        {
+          substring.push_back(Substring(j - length + reference_start + 1, i - length + sample_start + 1, length));
+        } // else
+      } // if
+
+      // We can stop if the whole sample string is part of the LCS.
+      if (length >= sample_length)
+      {
+        break;
+      } // if
+    } // for
   } // for
 
+  // Cleaning up.
+  delete[] occurrence;
+  delete[] diagonal_length;
+  delete[] diagonal_row;
 
-  // No LCS found: no frame shift annotation.
-  if (lcs.length <= 0)
+  return length;
+} // LCS_1_sparse
+
+// Compares 64 bit-sliced counters (stored as bit planes, least
+// significant plane first) against a threshold. Returns the mask of
+// counters greater than or equal to the threshold.
+static inline uint64_t plane_greater_equal(uint64_t const* const plane,
+                                           size_t const          planes,
+                                           size_t const          threshold)
+{
+  if ((threshold >> planes) != 0)
   {
-    return;
+    return 0x0ull;
   } // if
-
-
-#if defined(__debug__)
-  fprintf(stderr, "  LCS type = %d\n", lcs.type);
-  fprintf(stderr, "    %ld--%ld: ", lcs.reference_index, lcs.reference_index + lcs.length);
-  Dprint_truncated(reference, lcs.reference_index, lcs.reference_index + lcs.length);
-  fprintf(stderr, " (%ld)\n    %ld--%ld: ", lcs.length, lcs.sample_index, lcs.sample_index + lcs.length);
-  Dprint_truncated(sample, lcs.sample_index, lcs.sample_index + lcs.length);
-  fprintf(stderr, " (%ld)", lcs.length);
-  fputs("\n", stderr);
-#endif
-
-
-  // Calculate the frame shift probability.
-  double probability = 1.f;
-  for (size_t i = 0; i < lcs.length; ++i)
+  uint64_t greater = 0x0ull;
+  uint64_t equal = ~0x0ull;
+  for (size_t k = planes; k-- > 0; )
   {
-    double probability_compound = .0f;
-    if ((lcs.type & FRAME_SHIFT_1) == FRAME_SHIFT_1)
-    {
-      probability_compound += frame_shift_frequency[reference[lcs.reference_index + i] & 0x7f][reference[lcs.reference_index + i + 1] & 0x7f][0];
-    } // if
-    if ((lcs.type & FRAME_SHIFT_2) == FRAME_SHIFT_2)
-    {
-      probability_compound += frame_shift_frequency[reference[lcs.reference_index + i] & 0x7f][reference[lcs.reference_index + i + 1] & 0x7f][1];
-    } // if
-    if ((lcs.type & FRAME_SHIFT_REVERSE) == FRAME_SHIFT_REVERSE)
-    {
-      probability_compound += frame_shift_frequency[reference[lcs.reference_index + i] & 0x7f][reference[lcs.reference_index + i] & 0x7f][2];
-    } // if
-    if ((lcs.type & FRAME_SHIFT_REVERSE_1) == FRAME_SHIFT_REVERSE_1)
+    if (((threshold >> k) & 0x1) == 0x1)
     {
-      probability_compound += frame_shift_frequency[reference[lcs.reference_index + i] & 0x7f][reference[lcs.reference_index + i + 1] & 0x7f][3];
+      equal &= plane[k];
     } // if
-    if ((lcs.type & FRAME_SHIFT_REVERSE_2) == FRAME_SHIFT_REVERSE_2)
+    else
     {
-      probability_compound += frame_shift_frequency[reference[lcs.reference_index + i] & 0x7f][reference[lcs.reference_index + i + 1] & 0x7f][4];
-    } // if
-    probability *= probability_compound;
+      greater |= equal & plane[k];
+    } // else
   } // for
+  return greater | equal;
+} // plane_greater_equal
 
-
-  // Recursively apply this function to the prefixes of the strings.
-  std::vector<Variant> prefix;
-  extractor_frame_shift(prefix, reference, reference_start, lcs.reference_index, sample, sample_start, lcs.sample_index);
-
-
-  // Recursively apply this function to the suffixes of the strings.
-  std::vector<Variant> suffix;
-  extractor_frame_shift(suffix, reference, lcs.reference_index + lcs.length, reference_end, sample, lcs.sample_index + lcs.length, sample_end);
-
-
-  // Add all variants (in order) to the annotation vector.
-  annotation.insert(annotation.end(), prefix.begin(), prefix.end());
-  Variant variant(lcs.reference_index, lcs.reference_index + lcs.length, lcs.sample_index, lcs.sample_index + lcs.length, FRAME_SHIFT | lcs.type);
-  variant.probability = probability;
-  annotation.push_back(variant);
-  annotation.insert(annotation.end(), suffix.begin(), suffix.end());
-
-  return;
-} // extractor_frame_shift
-
-// This function calculates the LCS using the LCS_k function by
-// choosing an initial k and reducing it if necessary until the
-// strings represent random strings modeled by a threshold value.
-size_t LCS(std::vector<Substring> &substring,
-           char_t const* const     reference,
-           char_t const* const     complement,
-           size_t const            reference_start,
-           size_t const            reference_end,
-           char_t const* const     sample,
-           size_t const            sample_start,
-           size_t const            sample_end,
-           size_t const            cut_off)
+// Reads a single bit-sliced counter.
+static inline size_t plane_value(uint64_t const* const plane,
+                                 size_t const          planes,
+                                 size_t const          bit)
+{
+  size_t value = 0;
+  for (size_t k = 0; k < planes; ++k)
+  {
+    value |= ((plane[k] >> bit) & 0x1ull) << k;
+  } // for
+  return value;
+} // plane_value
+
+// Calculate the LCS with the same dynamic programming recurrence as
+// LCS_1, but 64 cells of a row at a time. Each cell counter is stored
+// bit-sliced over a number of bit planes, so that the diagonal
+// extension (shift and increment under the match mask) is a handful
+// of word operations. Only cells that reach the current maximal
+// length are inspected individually, in the same order as LCS_1 to
+// keep the same tie-breaking.
+size_t LCS_1_bit_parallel(std::vector<Substring> &substring,
+                          char_t const* const     reference,
+                          char_t const* const     complement,
+                          size_t const            reference_start,
+                          size_t const            reference_end,
+                          char_t const* const     sample,
+                          size_t const            sample_start,
+                          size_t const            sample_end)
 {
   size_t const reference_length = reference_end - reference_start;
   size_t const sample_length = sample_end - sample_start;
+  bool reverse_complement = false;
 
+  size_t length = 0;
 
-  // The initial k.
-  size_t k = reference_length > sample_length ? sample_length / 8 : reference_length / 8;
-
-
-  // Reduce k until the cut-off is reached.
-  while (k > 8 && k > cut_off)
+  if (reference_length <= 0 || sample_length <= 0)
   {
+    return length;
+  } // if
 
+  // The number of words in a row and the number of bit planes needed
+  // to count up to the maximal possible substring length.
+  size_t const words = (reference_length + 63) / 64;
+  size_t const maximum = reference_length < sample_length ? reference_length : sample_length;
+  size_t planes = 1;
+  while ((maximum >> planes) != 0)
+  {
+    ++planes;
+  } // while
 
-#if defined(__debug__)
-  fprintf(stderr, "  k = %ld (cut-off: %ld)\n", k, cut_off);
-#endif
-
-
-    // Try to find a LCS with k.
-    substring.clear();
-    size_t const length = LCS_k(substring, reference, complement, reference_start, reference_end, sample, sample_start, sample_end, k);
+  // Every symbol in the reference (or complement) window gets its own
+  // match bitmask; row 0 is reserved for symbols that never match
+  // (including the MASK character).
+  size_t symbol[256] = {0};
+  size_t symbols = 0;
+  for (size_t j = 0; j < reference_length; ++j)
+  {
+    unsigned char const base = reference[reference_start + j];
+    if (base != static_cast<unsigned char>(MASK) && symbol[base] == 0)
+    {
+      symbol[base] = ++symbols;
+    } // if
+    if (complement != 0)
+    {
+      unsigned char const base_rc = complement[reference_end - j - 1];
+      if (base_rc != static_cast<unsigned char>(MASK) && symbol[base_rc] == 0)
+      {
+        symbol[base_rc] = ++symbols;
+      } // if
+    } // if
+  } // for
 
-    // A LCS of sufficient length has been found.
-    if (length >= 2 * k && substring.size() > 0)
+  uint64_t* const match = new uint64_t[(symbols + 1) * words]();
+  uint64_t* const match_rc = new uint64_t[(symbols + 1) * words]();
+  for (size_t j = 0; j < reference_length; ++j)
+  {
+    unsigned char const base = reference[reference_start + j];
+    if (base != static_cast<unsigned char>(MASK))
     {
-      return length;
+      match[symbol[base] * words + j / 64] |= 0x1ull << (j % 64);
     } // if
-    k /= 3;
-  } // while
+    // The complement string is traversed backwards (towards the
+    // start) as in LCS_1.
+    if (complement != 0)
+    {
+      unsigned char const base_rc = complement[reference_end - j - 1];
+      if (base_rc != static_cast<unsigned char>(MASK))
+      {
+        match_rc[symbol[base_rc] * words + j / 64] |= 0x1ull << (j % 64);
+      } // if
+    } // if
+  } // for
 
-  // Cut-off: no LCS found.
-  if (cut_off > 1)
+  // The bit-sliced counters of the current row, for each word the
+  // planes are stored consecutively.
+  uint64_t* const LCS_plane = new uint64_t[words * planes]();
+  uint64_t* const LCS_plane_rc = new uint64_t[words * planes]();
+  uint64_t carry[64];
+  uint64_t carry_rc[64];
+
+  for (size_t i = 0; i < sample_length; ++i)
   {
+    unsigned char const base = sample[sample_start + i];
+    uint64_t const* const row = match + symbol[base] * words;
+    uint64_t const* const row_rc = match_rc + symbol[base] * words;
 
+    for (size_t k = 0; k < planes; ++k)
+    {
+      carry[k] = 0x0ull;
+      carry_rc[k] = 0x0ull;
+    } // for
 
-#if defined(__debug__)
-  fprintf(stderr, "  cut-off\n");
-#endif
+    bool stop = false;
+    for (size_t w = 0; w < words && !stop; ++w)
+    {
+      uint64_t* const plane = LCS_plane + w * planes;
+      uint64_t* const plane_rc = LCS_plane_rc + w * planes;
+
+      // Extend along the diagonal: shift the previous row by one cell
+      // and increment under the match mask (cleared otherwise).
+      uint64_t increment = row[w];
+      uint64_t increment_rc = row_rc[w];
+      for (size_t k = 0; k < planes; ++k)
+      {
+        uint64_t const shifted = (plane[k] << 1) | carry[k];
+        uint64_t const shifted_rc = (plane_rc[k] << 1) | carry_rc[k];
+        carry[k] = plane[k] >> 63;
+        carry_rc[k] = plane_rc[k] >> 63;
+        plane[k] = (shifted ^ increment) & row[w];
+        plane_rc[k] = (shifted_rc ^ increment_rc) & row_rc[w];
+        increment &= shifted;
+        increment_rc &= shifted_rc;
+      } // for
 
+      // Candidates for a new maximal length. The length can only grow
+      // while traversing the word, so these are a superset of the
+      // cells that actually qualify.
+      uint64_t const candidate = plane_greater_equal(plane, planes, length) & row[w];
+      uint64_t const candidate_rc = plane_greater_equal(plane_rc, planes, length < 2 ? 2 : length + 1) & row_rc[w];
 
-    substring.clear();
-    return 0;
-  } // if
+      uint64_t remaining = candidate | candidate_rc;
+      while (remaining != 0x0ull)
+      {
+        size_t const bit = __builtin_ctzll(remaining);
+        remaining &= remaining - 1;
+        size_t const j = w * 64 + bit;
 
+        // Check for a new maximal length.
+        if (((candidate >> bit) & 0x1ull) == 0x1ull)
+        {
+          size_t const value = plane_value(plane, planes, bit);
+          if (value >= length)
+          {
+            if (reverse_complement || value > length)
+            {
+              length = value;
+              substring = std::vector<Substring>(1, Substring(j - length + reference_start + 1, i - length + sample_start + 1, length));
+            } // if
+            else
+            {
+              substring.push_back(Substring(j - length + reference_start + 1, i - length + sample_start + 1, length));
+            } // else
+            reverse_complement = false;
+          } // if
+        } // if
 
-#if defined(__debug__)
-  fprintf(stderr, "  k = 1\n");
-#endif
+        // The same for a LCS in reverse complement space.
+        if (((candidate_rc >> bit) & 0x1ull) == 0x1ull)
+        {
+          size_t const value = plane_value(plane_rc, planes, bit);
+          if (value > 1 && value > length)
+          {
+            length = value;
+            substring = std::vector<Substring>(1, Substring(reference_end - j - 1, i - length + sample_start + 1, length, true));
+            reverse_complement = true;
+          } // if
+        } // if
 
+        // We can stop if the whole sample string is part of the LCS.
+        if (!reverse_complement && length >= sample_length)
+        {
+          stop = true;
+          break;
+        } // if
+      } // while
+    } // for
+  } // for
 
-  // As a last resort try running the classical algorithm.
-  return LCS_1(substring, reference, complement, reference_start, reference_end, sample, sample_start, sample_end);
-} // LCS
+  // Cleaning up.
+  delete[] match;
+  delete[] match_rc;
+  delete[] LCS_plane;
+  delete[] LCS_plane_rc;
 
-// Calculate the LCS in the well-known way using dynamic programming.
-// NOT suitable for large strings.
-size_t LCS_1(std::vector<Substring> &substring,
-             char_t const* const     reference,
-             char_t const* const     complement,
-             size_t const            reference_start,
-             size_t const            reference_end,
-             char_t const* const     sample,
-             size_t const            sample_start,
-             size_t const            sample_end)
+  return length;
+} // LCS_1_bit_parallel
+
+// Calculate the LCS using a suffix automaton of the reference string.
+// The sample string is traversed once through the automaton giving
+// for every position the longest match ending there. All occurrences
+// of a maximal match in the reference are the end positions of its
+// automaton state, found in the subtree of the suffix link tree. The
+// substrings are reported in the same order as LCS_1.
+size_t LCS_suffix_automaton(std::vector<Substring> &substring,
+                            char_t const* const     reference,
+                            size_t const            reference_start,
+                            size_t const            reference_end,
+                            char_t const* const     sample,
+                            size_t const            sample_start,
+                            size_t const            sample_end)
 {
+  static uint32_t const NONE = static_cast<uint32_t>(-1);
+
   size_t const reference_length = reference_end - reference_start;
   size_t const sample_length = sample_end - sample_start;
-  bool reverse_complement = false;
 
-  // Just a fancy way of allocation a continuous 2D array in heap
-  // space.
-  typedef size_t array[2][reference_length];
-  array &LCS_line = *(reinterpret_cast<array*>(new size_t[2 * reference_length]));
-  array &LCS_line_rc = *(reinterpret_cast<array*>(new size_t[2 * reference_length]));
+  if (reference_length <= 0 || sample_length <= 0)
+  {
+    return 0;
+  } // if
 
-  size_t length = 0;
+  // A dense alphabet of the reference string.
+  uint32_t symbol[256];
+  for (size_t c = 0; c < 256; ++c)
+  {
+    symbol[c] = NONE;
+  } // for
+  size_t symbols = 0;
+  for (size_t j = 0; j < reference_length; ++j)
+  {
+    uint8_t const c = static_cast<uint8_t>(reference[reference_start + j]);
+    if (symbol[c] == NONE)
+    {
+      symbol[c] = static_cast<uint32_t>(symbols++);
+    } // if
+  } // for
 
-  // Filling the LCS matrix (actually only the current and the
-  // previous row).
-  for (size_t i = 0; i < sample_length; ++i)
+  // The suffix automaton: at most 2 * |reference| states.
+  size_t const states_max = 2 * reference_length;
+  uint32_t* const next = new uint32_t[states_max * symbols];
+  uint32_t* const length = new uint32_t[states_max];
+  uint32_t* const link = new uint32_t[states_max];
+  uint32_t* const last_position = new uint32_t[states_max];
+  bool* const clone = new bool[states_max];
+  for (size_t i = 0; i < states_max * symbols; ++i)
   {
-    for (size_t j = 0; j < reference_length; ++j)
+    next[i] = NONE;
+  } // for
+
+  length[0] = 0;
+  link[0] = NONE;
+  clone[0] = true;
+  size_t states = 1;
+  uint32_t last = 0;
+  for (size_t j = 0; j < reference_length; ++j)
+  {
+    size_t const c = symbol[static_cast<uint8_t>(reference[reference_start + j])];
+    uint32_t const current = static_cast<uint32_t>(states++);
+    length[current] = length[last] + 1;
+    last_position[current] = static_cast<uint32_t>(j);
+    clone[current] = false;
+    uint32_t p = last;
+    while (p != NONE && next[p * symbols + c] == NONE)
     {
-      // A match
-      if (reference[reference_start + j] == sample[sample_start + i] && reference[reference_start + j] != MASK)
+      next[p * symbols + c] = current;
+      p = link[p];
+    } // while
+    if (p == NONE)
+    {
+      link[current] = 0;
+    } // if
+    else
+    {
+      uint32_t const q = next[p * symbols + c];
+      if (length[p] + 1 == length[q])
       {
-        if (i == 0 || j == 0)
+        link[current] = q;
+      } // if
+      else
+      {
+        uint32_t const copy = static_cast<uint32_t>(states++);
+        length[copy] = length[p] + 1;
+        link[copy] = link[q];
+        last_position[copy] = last_position[q];
+        clone[copy] = true;
+        for (size_t k = 0; k < symbols; ++k)
         {
-          LCS_line[i % 2][j] = 1;
+          next[copy * symbols + k] = next[q * symbols + k];
+        } // for
+        while (p != NONE && next[p * symbols + c] == q)
+        {
+          next[p * symbols + c] = copy;
+          p = link[p];
+        } // while
+        link[q] = copy;
+        link[current] = copy;
+      } // else
+    } // else
+    last = current;
+  } // for
+
+  // The longest match (and its state) ending at every sample position.
+  // The MASK character never matches.
+  uint32_t* const match_state = new uint32_t[sample_length];
+  uint32_t* const match_length = new uint32_t[sample_length];
+  size_t LCS_length = 0;
+  {
+    uint32_t v = 0;
+    uint32_t l = 0;
+    for (size_t i = 0; i < sample_length; ++i)
+    {
+      uint8_t const character = static_cast<uint8_t>(sample[sample_start + i]);
+      size_t const c = symbol[character];
+      if (character == static_cast<uint8_t>(MASK) || c == NONE)
+      {
+        v = 0;
+        l = 0;
+      } // if
+      else
+      {
+        while (v != 0 && next[v * symbols + c] == NONE)
+        {
+          v = link[v];
+          l = length[v];
+        } // while
+        if (next[v * symbols + c] != NONE)
+        {
+          v = next[v * symbols + c];
+          ++l;
         } // if
         else
         {
-          LCS_line[i % 2][j] = LCS_line[(i + 1) % 2][j - 1] + 1;
+          v = 0;
+          l = 0;
         } // else
+      } // else
+      match_state[i] = v;
+      match_length[i] = l;
+      if (l > LCS_length)
+      {
+        LCS_length = l;
+      } // if
+    } // for
+  }
 
-        // Check for a new maximal length.
-        if (LCS_line[i % 2][j] >= length)
+  if (LCS_length > 0)
+  {
+    // The suffix link tree (children in a compact adjacency list).
+    uint32_t* const child_start = new uint32_t[states + 1];
+    uint32_t* const child = new uint32_t[states];
+    for (size_t v = 0; v <= states; ++v)
+    {
+      child_start[v] = 0;
+    } // for
+    for (size_t v = 1; v < states; ++v)
+    {
+      ++child_start[link[v] + 1];
+    } // for
+    for (size_t v = 0; v < states; ++v)
+    {
+      child_start[v + 1] += child_start[v];
+    } // for
+    {
+      uint32_t* const fill = new uint32_t[states];
+      for (size_t v = 0; v < states; ++v)
+      {
+        fill[v] = child_start[v];
+      } // for
+      for (size_t v = 1; v < states; ++v)
+      {
+        child[fill[link[v]]++] = static_cast<uint32_t>(v);
+      } // for
+      delete[] fill;
+    }
+
+    std::vector<Substring> result;
+    std::vector<uint32_t> position;
+    std::vector<uint32_t> stack;
+    uint32_t previous = NONE;
+    for (size_t i = 0; i < sample_length; ++i)
+    {
+      if (match_length[i] != LCS_length)
+      {
+        continue;
+      } // if
+
+      // All end positions of the match in the reference (the same
+      // state gives the same positions).
+      if (match_state[i] != previous)
+      {
+        previous = match_state[i];
+        position.clear();
+        stack.push_back(previous);
+        while (!stack.empty())
         {
-          if (reverse_complement || LCS_line[i % 2][j] > length)
+          uint32_t const v = stack.back();
+          stack.pop_back();
+          if (!clone[v])
           {
-            length = LCS_line[i % 2][j];
-            substring = std::vector<Substring>(1, Substring(j - length + reference_start + 1, i - length + sample_start + 1, length));
+            position.push_back(last_position[v]);
           } // if
-          else
+          for (size_t k = child_start[v]; k < child_start[v + 1]; ++k)
           {
-            substring.push_back(Substring(j - length + reference_start + 1, i - length + sample_start + 1, length));
-          } // else
-          reverse_complement = false;
-        } // if
+            stack.push_back(child[k]);
+          } // for
+        } // while
+        std::sort(position.begin(), position.end());
       } // if
-      else
-      {
-        LCS_line[i % 2][j] = 0;
-      } // else
 
-      // If applicable check for a LCS in reverse complement space.
-      // The same code is used as before but the complement string is
-      // travesed backwards (towards the start).
-      if (complement != 0 && complement[reference_end - j - 1] == sample[sample_start + i] && complement[reference_end - j - 1] != MASK)
+      for (std::vector<uint32_t>::const_iterator it = position.begin(); it != position.end(); ++it)
       {
-        if (i == 0 || j == 0)
-        {
-          LCS_line_rc[i % 2][j] = 1;
-        } // if
-        else
-        {
-          LCS_line_rc[i % 2][j] = LCS_line_rc[(i + 1) % 2][j - 1] + 1;
-        } // else
+        result.push_back(Substring(reference_start + *it - LCS_length + 1, sample_start + i - LCS_length + 1, LCS_length));
 
-        if (LCS_line_rc[i % 2][j] > 1 && LCS_line_rc[i % 2][j] > length)
+        // Like LCS_1: stop if the whole sample string is part of the
+        // LCS.
+        if (LCS_length >= sample_length)
         {
-          length = LCS_line_rc[i % 2][j];
-          substring = std::vector<Substring>(1, Substring(reference_end - j - 1, i - length + sample_start + 1, length, true));
-          reverse_complement = true;
+          break;
         } // if
-      } // if
-      else
-      {
-        LCS_line_rc[i % 2][j] = 0;
-      } // else
-
-
-      // We can stop if the whole sample string is part of the LCS.
-      if (!reverse_complement && length >= sample_length)
-      {
-        break;
-      } // if
-
+      } // for
     } // for
-  } // for
+    substring.swap(result);
+
+    delete[] child_start;
+    delete[] child;
+  } // if
 
   // Cleaning up.
-  delete[] &LCS_line;
-  delete[] &LCS_line_rc;
+  delete[] next;
+  delete[] length;
+  delete[] link;
+  delete[] last_position;
+  delete[] clone;
+  delete[] match_state;
+  delete[] match_length;
 
-  return length;
-} // LCS_1
+  return LCS_length;
+} // LCS_suffix_automaton
 
 // Calculate the LCS using overlapping and non-overlapping k-mers.
 // This function should be suitable for large (similar) strings.
 // Be careful: if the resulting LCS is of length <= 2k it might not be
 // the actual LCS. Remedy: try again with a reduced k.
-size_t LCS_k(std::vector<Substring> &substring,
-             char_t const* const     reference,
-             char_t const* const     complement,
-             size_t const            reference_start,
-             size_t const            reference_end,
-             char_t const* const     sample,
-             size_t const            sample_start,
-             size_t const            sample_end,
-             size_t const            k)
+template <bool COMPLEMENT, bool MASKED>
+static size_t LCS_k(std::vector<Substring> &substring,
+                    char_t const* const     reference,
+                    char_t const* const     complement,
+                    size_t const            reference_start,
+                    size_t const            reference_end,
+                    char_t const* const     sample,
+                    size_t const            sample_start,
+                    size_t const            sample_end,
+                    size_t const            k)
 {
   size_t length = 0;
 
@@ -1124,9 +3333,9 @@ size_t LCS_k(std::vector<Substring> &substring,
 
   // Just a fancy way of allocation a continuous (k+1)D array in heap
   // space.
-  typedef size_t array[k + 1][reference_length];
-  array &LCS_line = *(reinterpret_cast<array*>(new size_t[(k + 1) * reference_length]));
-  array &LCS_line_rc = *(reinterpret_cast<array*>(new size_t[(k + 1) * reference_length]));
+  typedef position_t array[k + 1][reference_length];
+  array &LCS_line = *(reinterpret_cast<array*>(new position_t[(k + 1) * reference_length]));
+  array &LCS_line_rc = *(reinterpret_cast<array*>(new position_t[(k + 1) * reference_length]));
 
   // Filling the LCS k-mer matrix (actually only the current and the k
   // previous rows). We count in k-mers.
@@ -1135,7 +3344,7 @@ size_t LCS_k(std::vector<Substring> &substring,
     for (size_t j = 0; j < reference_length; ++j) // non-overlapping
     {
       // A match
-      if (string_match(reference + reference_start + j * k, sample + sample_start + i, k))
+      if (string_match<MASKED>(reference + reference_start + j * k, sample + sample_start + i, k))
       {
         if (i < k || j == 0)
         {
@@ -1179,7 +3388,7 @@ size_t LCS_k(std::vector<Substring> &substring,
       // If applicable check for a LCS in reverse complement space.
       // The same code is used as before but the complement string is
       // travesed backwards (towards the start).
-      if (complement != 0 && string_match_reverse(complement + reference_end - j * k - 1, sample + sample_start + i, k))
+      if (COMPLEMENT && string_match_reverse<MASKED>(complement + reference_end - j * k - 1, sample + sample_start + i, k))
       {
         if (i < k || j == 0)
         {
@@ -1238,7 +3447,7 @@ size_t LCS_k(std::vector<Substring> &substring,
       // Extending to the right.
       {
         size_t i = 0;
-        while (i <= k && it->reference_index + it->length + i < reference_end && it->sample_index + it->length + i < sample_end && reference[it->reference_index + it->length + i] == sample[it->sample_index + it->length + i] && reference[it->reference_index + it->length + i] != MASK)
+        while (i <= k && it->reference_index + it->length + i < reference_end && it->sample_index + it->length + i < sample_end && reference[it->reference_index + it->length + i] == sample[it->sample_index + it->length + i] && unmasked<MASKED>(reference[it->reference_index + it->length + i]))
         {
           ++i;
         } // while
@@ -1247,7 +3456,7 @@ size_t LCS_k(std::vector<Substring> &substring,
       // Extending to the left.
       {
         size_t i = 0;
-        while (i <= k && it->reference_index - i - 1 >= reference_start && it->sample_index - i - 1 >= sample_start && reference[it->reference_index - i - 1] == sample[it->sample_index - i - 1] && reference[it->reference_index - i - 1] != MASK)
+        while (i <= k && it->reference_index - i - 1 >= reference_start && it->sample_index - i - 1 >= sample_start && reference[it->reference_index - i - 1] == sample[it->sample_index - i - 1] && unmasked<MASKED>(reference[it->reference_index - i - 1]))
         {
           ++i;
         } // while
@@ -1264,7 +3473,7 @@ size_t LCS_k(std::vector<Substring> &substring,
       // Extending to the right (sample orientation).
       {
         size_t i = 0;
-        while (i <= k && it->reference_index - i - 1 >= reference_start && it->sample_index + it->length + i < sample_end && complement[it->reference_index - i - 1] == sample[it->sample_index + it->length + i] && complement[it->reference_index - i - 1] != MASK)
+        while (i <= k && it->reference_index - i - 1 >= reference_start && it->sample_index + it->length + i < sample_end && complement[it->reference_index - i - 1] == sample[it->sample_index + it->length + i] && unmasked<MASKED>(complement[it->reference_index - i - 1]))
         {
           ++i;
         } // while
@@ -1274,7 +3483,7 @@ size_t LCS_k(std::vector<Substring> &substring,
       // Extending to the left (sample orientation).
       {
         size_t i = 0;
-        while (i <= k && it->reference_index + it->length + i < reference_end && it->sample_index - i - 1 >= sample_start && complement[it->reference_index + it->length + i] == sample[it->sample_index - i - 1] && complement[it->reference_index + it->length + i] != MASK)
+        while (i <= k && it->reference_index + it->length + i < reference_end && it->sample_index - i - 1 >= sample_start && complement[it->reference_index + it->length + i] == sample[it->sample_index - i - 1] && unmasked<MASKED>(complement[it->reference_index + it->length + i]))
         {
           ++i;
         } // while
@@ -1313,133 +3522,492 @@ size_t LCS_k(std::vector<Substring> &substring,
   return length;
 } // LCS_k
 
-// This function calculates the frame shift LCS. The five possible
-// frame shift LCSs are calculated separately. Picking the longest
-// ``best'' fitting one is the reponsibility of the caller.
-// This function is a version of the LCS_1 function (not suitable for
-// very large strings).
-void LCS_frame_shift(std::vector<Substring> &substring,
-                     char_t const* const     reference,
-                     size_t const            reference_start,
-                     size_t const            reference_end,
-                     char_t const* const     sample,
-                     size_t const            sample_start,
-                     size_t const            sample_end)
+// The LCS_k function for arbitrary (possibly masked) strings with or
+// without a complement string.
+size_t LCS_k(std::vector<Substring> &substring,
+             char_t const* const     reference,
+             char_t const* const     complement,
+             size_t const            reference_start,
+             size_t const            reference_end,
+             char_t const* const     sample,
+             size_t const            sample_start,
+             size_t const            sample_end,
+             size_t const            k)
+{
+  if (complement != 0)
+  {
+    return LCS_k<true, true>(substring, reference, complement, reference_start, reference_end, sample, sample_start, sample_end, k);
+  } // if
+  return LCS_k<false, true>(substring, reference, complement, reference_start, reference_end, sample, sample_start, sample_end, k);
+} // LCS_k
+
+// Heap storage (zero initialized) for the rows of vector lanes of the
+// frame shift LCS. The lanes are over-aligned, which plain new only
+// honours with the aligned new of C++17, so the storage is allocated
+// with posix_memalign instead.
+template <typename counter_t>
+struct Aligned_Lanes
+{
+  typedef counter_t lanes __attribute__((vector_size(8 * sizeof(counter_t))));
+
+  lanes* data;
+
+  explicit Aligned_Lanes(size_t const size): data(0)
+  {
+    void* memory = 0;
+    if (posix_memalign(&memory, alignof(lanes) < sizeof(void*) ? sizeof(void*) : alignof(lanes), (size > 0 ? size : 1) * sizeof(lanes)) != 0)
+    {
+      throw std::bad_alloc();
+    } // if
+    data = static_cast<lanes*>(memory);
+    for (size_t i = 0; i < size; ++i)
+    {
+      data[i] = lanes();
+    } // for
+  } // Aligned_Lanes
+
+  ~Aligned_Lanes(void)
+  {
+    free(data);
+  } // ~Aligned_Lanes
+
+  Aligned_Lanes(Aligned_Lanes const&) = delete;
+  Aligned_Lanes& operator=(Aligned_Lanes const&) = delete;
+}; // Aligned_Lanes
+
+// The five frame shift channels of the frame shift LCS are updated
+// together as the lanes of a vector (only the first five lanes are
+// used). The lane order follows the FRAME_SHIFT constants, i.e., lane
+// c corresponds to the frame shift bit (0x1 << c).
+template <typename counter_t>
+static void LCS_frame_shift_lanes(Substring            fs_substring[5],
+                                  uint8_t const* const channel,
+                                  size_t const* const  symbol,
+                                  size_t const         reference_start,
+                                  size_t const         reference_end,
+                                  uint8_t const* const sample_code,
+                                  size_t const         sample_start,
+                                  size_t const         sample_end)
 {
+  typedef typename Aligned_Lanes<counter_t>::lanes lanes;
+
   size_t const reference_length = reference_end - reference_start;
   size_t const sample_length = sample_end - sample_start;
 
-  size_t lcs[2][reference_length][5];
-  for (size_t i = 0; i < reference_length; ++i)
+  // Lane masks for all combinations of the five frame shift bits.
+  lanes expand[32];
+  for (size_t m = 0; m < 32; ++m)
   {
-    lcs[0][i][0] = 0;
-    lcs[0][i][1] = 0;
-    lcs[0][i][2] = 0;
-    lcs[0][i][3] = 0;
-    lcs[0][i][4] = 0;
-    lcs[1][i][0] = 0;
-    lcs[1][i][1] = 0;
-    lcs[1][i][2] = 0;
-    lcs[1][i][3] = 0;
-    lcs[1][i][4] = 0;
+    for (size_t c = 0; c < 8; ++c)
+    {
+      expand[m][c] = c < 5 && ((m >> c) & 0x1) == 0x1 ? static_cast<counter_t>(~0) : 0;
+    } // for
   } // for
 
-  Substring fs_substring[5];
+  // The current and the previous row of the LCS matrix.
+  Aligned_Lanes<counter_t> const storage(2 * reference_length);
+  lanes* const LCS_line = storage.data;
+  lanes best = lanes();
+
   for (size_t i = 0; i < sample_length; ++i)
   {
-    uint8_t const shift_reverse = frame_shift(reference[reference_end - 1], reference[reference_end - 1], sample[sample_start + i]);
-    if ((shift_reverse & FRAME_SHIFT_REVERSE) == FRAME_SHIFT_REVERSE)
+    uint8_t const* const row = channel + symbol[sample_code[i]] * reference_length;
+    lanes* const current = LCS_line + (i % 2) * reference_length;
+    lanes const* const previous = LCS_line + ((i + 1) % 2) * reference_length;
+
+    // The first column only has the (never reset) reverse channel.
+    if ((row[0] & FRAME_SHIFT_REVERSE) == FRAME_SHIFT_REVERSE)
     {
-      lcs[i % 2][0][2] = 1;
+      current[0][2] = 1;
     } // if
-    if (lcs[i % 2][0][2] > fs_substring[2].length)
+    if (current[0][2] > best[2])
     {
-      fs_substring[2] = Substring(reference_start - lcs[i % 2][0][2] + 1, sample_start + i - lcs[i % 2][0][2] + 1, lcs[i % 2][0][2], FRAME_SHIFT_REVERSE);
+      best[2] = current[0][2];
+      fs_substring[2] = Substring(reference_start - best[2] + 1, sample_start + i - best[2] + 1, best[2], FRAME_SHIFT_REVERSE);
     } // if
+
     for (size_t j = 1; j < reference_length; ++j)
     {
-      uint8_t const shift_forward = frame_shift(reference[reference_start + j - 1], reference[reference_start + j], sample[sample_start + i]);
-      uint8_t const shift_reverse = frame_shift(reference[reference_end - j - 1], reference[reference_end - j], sample[sample_start + i]);
-      if ((shift_forward & FRAME_SHIFT_1) == FRAME_SHIFT_1)
-      {
-        lcs[i % 2][j][0] = lcs[(i + 1) % 2][j - 1][0] + 1;
-      } // if
-      else
-      {
-        lcs[i % 2][j][0] = 0;
-      } // else
-      if ((shift_forward & FRAME_SHIFT_2) == FRAME_SHIFT_2)
-      {
-        lcs[i % 2][j][1] = lcs[(i + 1) % 2][j - 1][1] + 1;
-      } // if
-      else
+      lanes const value = (previous[j - 1] + 1) & expand[row[j]];
+      current[j] = value;
+
+      // Only inspect the individual lanes if any of them improves.
+      lanes const greater = value > best;
+      uint64_t any[sizeof(lanes) / sizeof(uint64_t)];
+      __builtin_memcpy(any, &greater, sizeof(lanes));
+      uint64_t improved = 0x0ull;
+      for (size_t k = 0; k < sizeof(lanes) / sizeof(uint64_t); ++k)
       {
-        lcs[i % 2][j][1] = 0;
-      } // else
-      if ((shift_reverse & FRAME_SHIFT_REVERSE) == FRAME_SHIFT_REVERSE)
+        improved |= any[k];
+      } // for
+      if (improved == 0x0ull)
       {
-        lcs[i % 2][j][2] = lcs[(i + 1) % 2][j - 1][2] + 1;
+        continue;
       } // if
-      else
+
+      for (size_t c = 0; c < 5; ++c)
       {
-        lcs[i % 2][j][2] = 0;
-      } // else
-      if ((shift_reverse & FRAME_SHIFT_REVERSE_1) == FRAME_SHIFT_REVERSE_1)
+        if (value[c] > best[c])
+        {
+          best[c] = value[c];
+          if (c < 2)
+          {
+            fs_substring[c] = Substring(reference_start + j - value[c], sample_start + i - value[c] + 1, value[c], static_cast<uint8_t>(0x1 << c));
+          } // if
+          else
+          {
+            fs_substring[c] = Substring(reference_end - j - 1, sample_start + i - value[c] + 1, value[c], static_cast<uint8_t>(0x1 << c));
+          } // else
+        } // if
+      } // for
+    } // for
+  } // for
+
+  return;
+} // LCS_frame_shift_lanes
+
+// The combined frame shifts of the reference string against every
+// distinct sample amino acid: the forward frame shifts (FRAME_SHIFT_1
+// and FRAME_SHIFT_2) of consecutive reference amino acids and the
+// reverse frame shifts of the reference traversed backwards. The rows
+// are indexed by symbol[sample_code[i]] and have reference_length
+// columns (the first column only has FRAME_SHIFT_REVERSE).
+// Returns the number of distinct sample amino acids.
+static size_t frame_shift_channel(uint8_t*           &channel,
+                                  uint8_t*           &sample_code,
+                                  size_t             symbol[32],
+                                  char_t const* const reference,
+                                  size_t const        reference_start,
+                                  size_t const        reference_end,
+                                  char_t const* const sample,
+                                  size_t const        sample_start,
+                                  size_t const        sample_end,
+                                  Codon_Table const&  codon_table)
+{
+  size_t const reference_length = reference_end - reference_start;
+  size_t const sample_length = sample_end - sample_start;
+
+  // Remap both strings to the compact amino acid codes and number
+  // the distinct amino acids in the sample string.
+  uint8_t* const reference_code = new uint8_t[reference_length];
+  for (size_t j = 0; j < reference_length; ++j)
+  {
+    reference_code[j] = codon_table.acid_code[reference[reference_start + j] & 0x7f];
+  } // for
+  sample_code = new uint8_t[sample_length];
+  bool present[32] = {false};
+  size_t symbols = 0;
+  for (size_t i = 0; i < sample_length; ++i)
+  {
+    uint8_t const acid = codon_table.acid_code[sample[sample_start + i] & 0x7f];
+    sample_code[i] = acid;
+    if (!present[acid])
+    {
+      present[acid] = true;
+      symbol[acid] = symbols++;
+    } // if
+  } // for
+
+  channel = new uint8_t[symbols * reference_length];
+  {
+    uint8_t const* const shift_reverse = codon_table.frame_shift_map[reference_code[reference_length - 1]][reference_code[reference_length - 1]];
+    for (size_t acid = 0; acid < 32; ++acid)
+    {
+      if (present[acid])
       {
-        lcs[i % 2][j][3] = lcs[(i + 1) % 2][j - 1][3] + 1;
+        channel[symbol[acid] * reference_length] = shift_reverse[acid] & FRAME_SHIFT_REVERSE;
       } // if
-      else
-      {
-        lcs[i % 2][j][3] = 0;
-      } // else
-      if ((shift_reverse & FRAME_SHIFT_REVERSE_2) == FRAME_SHIFT_REVERSE_2)
+    } // for
+  }
+  for (size_t j = 1; j < reference_length; ++j)
+  {
+    uint8_t const* const shift_forward = codon_table.frame_shift_map[reference_code[j - 1]][reference_code[j]];
+    uint8_t const* const shift_reverse = codon_table.frame_shift_map[reference_code[reference_length - j - 1]][reference_code[reference_length - j]];
+    for (size_t acid = 0; acid < 32; ++acid)
+    {
+      if (present[acid])
       {
-        lcs[i % 2][j][4] = lcs[(i + 1) % 2][j - 1][4] + 1;
+        channel[symbol[acid] * reference_length + j] = (shift_forward[acid] & (FRAME_SHIFT_1 | FRAME_SHIFT_2)) |
+                                                       (shift_reverse[acid] & (FRAME_SHIFT_REVERSE | FRAME_SHIFT_REVERSE_1 | FRAME_SHIFT_REVERSE_2));
       } // if
-      else
-      {
-        lcs[i % 2][j][4] = 0;
-      } // else
+    } // for
+  } // for
 
-      if (lcs[i % 2][j][0] > fs_substring[0].length)
-      {
-        fs_substring[0] = Substring(reference_start + j - lcs[i % 2][j][0], sample_start + i - lcs[i % 2][j][0] + 1, lcs[i % 2][j][0], FRAME_SHIFT_1);
-      } // if
-      if (lcs[i % 2][j][1] > fs_substring[1].length)
+  // Cleaning up.
+  delete[] reference_code;
+
+  return symbols;
+} // frame_shift_channel
+
+// This function calculates the frame shift LCS. The five possible
+// frame shift LCSs are calculated separately. Picking the longest
+// ``best'' fitting one is the reponsibility of the caller.
+// This function is a version of the LCS_1 function (not suitable for
+// very large strings). The frame shift map lookups are hoisted out
+// of the dynamic programming: for every distinct sample amino acid a
+// row of combined frame shifts along the reference is precalculated.
+void LCS_frame_shift(std::vector<Substring> &substring,
+                     char_t const* const     reference,
+                     size_t const            reference_start,
+                     size_t const            reference_end,
+                     char_t const* const     sample,
+                     size_t const            sample_start,
+                     size_t const            sample_end,
+                     Codon_Table const&      codon_table)
+{
+  size_t const reference_length = reference_end - reference_start;
+  size_t const sample_length = sample_end - sample_start;
+
+  Substring fs_substring[5];
+
+  if (reference_length > 0 && sample_length > 0)
+  {
+    uint8_t* channel = 0;
+    uint8_t* sample_code = 0;
+    size_t symbol[32];
+    frame_shift_channel(channel, sample_code, symbol, reference, reference_start, reference_end, sample, sample_start, sample_end, codon_table);
+
+    // Use the most compact counters possible.
+    if ((reference_length < sample_length ? reference_length : sample_length) < 0xffff)
+    {
+      LCS_frame_shift_lanes<uint16_t>(fs_substring, channel, symbol, reference_start, reference_end, sample_code, sample_start, sample_end);
+    } // if
+    else
+    {
+      LCS_frame_shift_lanes<uint32_t>(fs_substring, channel, symbol, reference_start, reference_end, sample_code, sample_start, sample_end);
+    } // else
+
+    // Cleaning up.
+    delete[] sample_code;
+    delete[] channel;
+  } // if
+
+  substring = std::vector<Substring>(1, fs_substring[0]);
+  substring.push_back(fs_substring[1]);
+  substring.push_back(fs_substring[2]);
+  substring.push_back(fs_substring[3]);
+  substring.push_back(fs_substring[4]);
+  return;
+} // LCS_frame_shift
+
+// This function collects all maximal frame shifted runs of at least
+// FRAME_SHIFT_RUN_LENGTH amino acids, i.e., the diagonals of the frame
+// shift LCS matrix, in a single pass. A run is stored as the
+// substring the LCS_frame_shift function would report for it: the
+// forward runs align the reference and the sample string, the
+// reverse runs traverse the reference backwards from
+// reference_index + length - 1.
+void LCS_frame_shift_runs(std::vector<Substring> &run,
+                          char_t const* const     reference,
+                          size_t const            reference_start,
+                          size_t const            reference_end,
+                          char_t const* const     sample,
+                          size_t const            sample_start,
+                          size_t const            sample_end,
+                          Codon_Table const&      codon_table)
+{
+  size_t const reference_length = reference_end - reference_start;
+  size_t const sample_length = sample_end - sample_start;
+
+  run.clear();
+  if (reference_length <= FRAME_SHIFT_RUN_LENGTH || sample_length < FRAME_SHIFT_RUN_LENGTH)
+  {
+    return;
+  } // if
+
+  uint8_t* channel = 0;
+  uint8_t* sample_code = 0;
+  size_t symbol[32];
+  frame_shift_channel(channel, sample_code, symbol, reference, reference_start, reference_end, sample, sample_start, sample_end, codon_table);
+
+  // A run starts in every cell (apart from the first column) of which
+  // the diagonal predecessor does not match and the next
+  // FRAME_SHIFT_RUN_LENGTH cells on the diagonal do match for the same
+  // frame shift. Its length is found by following the diagonal.
+  size_t const columns = reference_length - FRAME_SHIFT_RUN_LENGTH + 1;
+  uint8_t* const start = new uint8_t[columns + 8]();
+  for (size_t i = 0; i + FRAME_SHIFT_RUN_LENGTH <= sample_length; ++i)
+  {
+    uint8_t const* const row = channel + symbol[sample_code[i]] * reference_length;
+    for (size_t j = 1; j < columns; ++j)
+    {
+      start[j] = row[j];
+    } // for
+    for (size_t k = 1; k < FRAME_SHIFT_RUN_LENGTH; ++k)
+    {
+      uint8_t const* const next = channel + symbol[sample_code[i + k]] * reference_length + k;
+      for (size_t j = 1; j < columns; ++j)
       {
-        fs_substring[1] = Substring(reference_start + j - lcs[i % 2][j][1], sample_start + i - lcs[i % 2][j][1] + 1, lcs[i % 2][j][1], FRAME_SHIFT_2);
-      } // if
-      if (lcs[i % 2][j][2] > fs_substring[2].length)
+        start[j] &= next[j];
+      } // for
+    } // for
+    if (i > 0)
+    {
+      uint8_t const* const previous = channel + symbol[sample_code[i - 1]] * reference_length - 1;
+      for (size_t j = 2; j < columns; ++j)
       {
-        fs_substring[2] = Substring(reference_end - j - 1, sample_start + i - lcs[i % 2][j][2] + 1, lcs[i % 2][j][2], FRAME_SHIFT_REVERSE);
-      } // if
-      if (lcs[i % 2][j][3] > fs_substring[3].length)
+        start[j] &= ~previous[j];
+      } // for
+    } // if
+
+    for (size_t j = 1; j < columns; ++j)
+    {
+      // Skip eight cells without any run at once.
+      uint64_t word;
+      __builtin_memcpy(&word, start + j, sizeof(word));
+      if (word == 0x0ull)
       {
-        fs_substring[3] = Substring(reference_end - j - 1, sample_start + i - lcs[i % 2][j][3] + 1, lcs[i % 2][j][3], FRAME_SHIFT_REVERSE_1);
+        j += 7;
+        continue;
       } // if
-      if (lcs[i % 2][j][4] > fs_substring[4].length)
+      uint8_t shift = start[j];
+      while (shift != 0)
       {
-        fs_substring[4] = Substring(reference_end - j - 1, sample_start + i - lcs[i % 2][j][4] + 1, lcs[i % 2][j][4], FRAME_SHIFT_REVERSE_2);
-      } // if
+        uint8_t const type = shift & -shift;
+        shift ^= type;
+        size_t length = FRAME_SHIFT_RUN_LENGTH;
+        while (i + length < sample_length && j + length < reference_length &&
+               (channel[symbol[sample_code[i + length]] * reference_length + j + length] & type) == type)
+        {
+          ++length;
+        } // while
+        if (type == FRAME_SHIFT_1 || type == FRAME_SHIFT_2)
+        {
+          run.push_back(Substring(reference_start + j - 1, sample_start + i, length, type));
+        } // if
+        else
+        {
+          run.push_back(Substring(reference_end - j - length, sample_start + i, length, type));
+        } // else
+      } // while
     } // for
   } // for
+
+  // Cleaning up.
+  delete[] start;
+  delete[] sample_code;
+  delete[] channel;
+
+  return;
+} // LCS_frame_shift_runs
+
+// This function answers the LCS_frame_shift function from the
+// frame shifted runs (clipped to the given ranges) instead of the
+// dynamic programming matrix. The first column of the matrix is
+// mimicked exactly: its FRAME_SHIFT_REVERSE channel is never reset and
+// extends the runs starting in the second column. Only the frame
+// shifts of the longest length are calculated; if this length is
+// less than FRAME_SHIFT_RUN_LENGTH (these runs are not stored) the
+// LCS_frame_shift function is used instead.
+void LCS_frame_shift_clipped(std::vector<Substring>       &substring,
+                             std::vector<Substring> const &run,
+                             char_t const* const           reference,
+                             size_t const                  reference_start,
+                             size_t const                  reference_end,
+                             char_t const* const           sample,
+                             size_t const                  sample_start,
+                             size_t const                  sample_end,
+                             Codon_Table const&            codon_table)
+{
+  size_t const reference_length = reference_end - reference_start;
+  size_t const sample_length = sample_end - sample_start;
+
+  if (run.empty() || reference_length <= FRAME_SHIFT_RUN_LENGTH || sample_length < FRAME_SHIFT_RUN_LENGTH)
+  {
+    LCS_frame_shift(substring, reference, reference_start, reference_end, sample, sample_start, sample_end, codon_table);
+    return;
+  } // if
+
+  // The (never reset) first column: it alternates between two rows.
+  uint8_t const* const shift_first = codon_table.frame_shift_map[codon_table.acid_code[reference[reference_end - 1] & 0x7f]][codon_table.acid_code[reference[reference_end - 1] & 0x7f]];
+  bool* const first_column = new bool[sample_length];
+  for (size_t i = 0; i < sample_length; ++i)
+  {
+    first_column[i] = (shift_first[codon_table.acid_code[sample[sample_start + i] & 0x7f]] & FRAME_SHIFT_REVERSE) == FRAME_SHIFT_REVERSE ||
+                      (i > 1 && first_column[i - 2]);
+  } // for
+
+  // Per frame shift the first cell (row by row) of the longest run.
+  Substring fs_substring[5];
+  size_t row[5] = {0};
+  size_t column[5] = {0};
+
+  // The runs of length FRAME_SHIFT_RUN_LENGTH - 1 in the second column
+  // (not stored) can be extended by the first column.
+  for (size_t i = 1; i + FRAME_SHIFT_RUN_LENGTH - 1 <= sample_length; ++i)
+  {
+    if (!first_column[i - 1])
+    {
+      continue;
+    } // if
+    size_t length = 0;
+    while (length < FRAME_SHIFT_RUN_LENGTH && i + length < sample_length && length + 1 < reference_length &&
+           (codon_table.frame_shift_map[codon_table.acid_code[reference[reference_end - length - 2] & 0x7f]][codon_table.acid_code[reference[reference_end - length - 1] & 0x7f]][codon_table.acid_code[sample[sample_start + i + length] & 0x7f]] & FRAME_SHIFT_REVERSE) == FRAME_SHIFT_REVERSE)
+    {
+      ++length;
+    } // while
+    if (length == FRAME_SHIFT_RUN_LENGTH - 1)
+    {
+      fs_substring[2] = Substring(reference_end - length - 1, sample_start + i - 1, FRAME_SHIFT_RUN_LENGTH, FRAME_SHIFT_REVERSE);
+      row[2] = sample_start + i + length - 1;
+      column[2] = length;
+      break;
+    } // if
+  } // for
+
+  for (std::vector<Substring>::const_iterator it = run.begin(); it != run.end(); ++it)
+  {
+    size_t const c = __builtin_ctz(it->type);
+    size_t extend = 0;
+    if (it->type == FRAME_SHIFT_REVERSE && it->reference_index + it->length == reference_end - 1 &&
+        it->sample_index > sample_start && first_column[it->sample_index - sample_start - 1])
+    {
+      extend = 1;
+    } // if
+    size_t const length = it->length + extend;
+    size_t const last_row = it->sample_index + it->length - 1;
+    size_t const last_column = c < 2 ? it->reference_index + it->length - reference_start : reference_end - it->reference_index - 1;
+    if (length > fs_substring[c].length ||
+        (length == fs_substring[c].length && (last_row < row[c] || (last_row == row[c] && last_column < column[c]))))
+    {
+      fs_substring[c] = Substring(it->reference_index, it->sample_index - extend, length, it->type);
+      row[c] = last_row;
+      column[c] = last_column;
+    } // if
+  } // for
+
+  // Cleaning up.
+  delete[] first_column;
+
+  size_t length = 0;
+  for (size_t c = 0; c < 5; ++c)
+  {
+    length = std::max(length, static_cast<size_t>(fs_substring[c].length));
+  } // for
+  if (length < FRAME_SHIFT_RUN_LENGTH)
+  {
+    LCS_frame_shift(substring, reference, reference_start, reference_end, sample, sample_start, sample_end, codon_table);
+    return;
+  } // if
+
   substring = std::vector<Substring>(1, fs_substring[0]);
   substring.push_back(fs_substring[1]);
   substring.push_back(fs_substring[2]);
   substring.push_back(fs_substring[3]);
   substring.push_back(fs_substring[4]);
   return;
-} // LCS_frame_shift
+} // LCS_frame_shift_clipped
 
 // This function is more or less equivalent to C's strncmp, but it
 // returns true iff both strings are the same.
-bool string_match(char_t const* const string_1,
-                  char_t const* const string_2,
-                  size_t const        length)
+template <bool MASKED>
+static bool string_match(char_t const* const string_1,
+                         char_t const* const string_2,
+                         size_t const        length)
 {
   for (size_t i = 0; i < length; ++i)
   {
-    if (string_1[i] != string_2[i] || string_1[i] == MASK)
+    if (string_1[i] != string_2[i] || !unmasked<MASKED>(string_1[i]))
     {
       return false;
     } // if
@@ -1447,17 +4015,26 @@ bool string_match(char_t const* const string_1,
   return true;
 } // string_match
 
+// The string_match function for arbitrary (possibly masked) strings.
+bool string_match(char_t const* const string_1,
+                  char_t const* const string_2,
+                  size_t const        length)
+{
+  return string_match<true>(string_1, string_2, length);
+} // string_match
+
 // This function is very similar to C's strncmp, but it traverses
 // string_1 from end to start while traversing string_2 from start to
 // end (useful for the reverse complement in DNA/RNA), and it returns
 // true iff both strings are the same in their respective directions.
-bool string_match_reverse(char_t const* const string_1,
-                          char_t const* const string_2,
-                          size_t const        length)
+template <bool MASKED>
+static bool string_match_reverse(char_t const* const string_1,
+                                 char_t const* const string_2,
+                                 size_t const        length)
 {
   for (size_t i = 0; i < length; ++i)
   {
-    if (string_1[-i] != string_2[i] || string_1[-i] == MASK)
+    if (string_1[-i] != string_2[i] || !unmasked<MASKED>(string_1[-i]))
     {
       return false;
     } // if
@@ -1465,46 +4042,104 @@ bool string_match_reverse(char_t const* const string_1,
   return true;
 } // string_match_reverse
 
+// The string_match_reverse function for arbitrary (possibly masked)
+// strings.
+bool string_match_reverse(char_t const* const string_1,
+                          char_t const* const string_2,
+                          size_t const        length)
+{
+  return string_match_reverse<true>(string_1, string_2, length);
+} // string_match_reverse
+
 // This function calculates the length (in characters) of the common
 // prefix between two strings. The result of this function is also
 // used in the suffix_match function.
-size_t prefix_match(char_t const* const reference,
-                    size_t const        reference_length,
-                    char_t const* const sample,
-                    size_t const        sample_length)
+template <bool MASKED>
+static size_t prefix_match(char_t const* const reference,
+                           size_t const        reference_length,
+                           char_t const* const sample,
+                           size_t const        sample_length)
 {
   size_t i = 0;
 
   // Traverse both strings towards the end as long as their characters
   // are equal. Do NOT exceed the length of the strings.
-  while (i < reference_length && i < sample_length && reference[i] == sample[i] && reference[i] != MASK)
+  while (i < reference_length && i < sample_length && reference[i] == sample[i] && unmasked<MASKED>(reference[i]))
   {
     ++i;
   } // while
   return i;
 } // prefix_match
 
-// This function calculates the length (in characters) of the common
-// suffix between two strings. It needs the calculated common prefix.
-size_t suffix_match(char_t const* const reference,
+// The prefix_match function for arbitrary (possibly masked) strings.
+size_t prefix_match(char_t const* const reference,
                     size_t const        reference_length,
                     char_t const* const sample,
-                    size_t const        sample_length,
-                    size_t const        prefix)
+                    size_t const        sample_length)
+{
+  return prefix_match<true>(reference, reference_length, sample, sample_length);
+} // prefix_match
 
+// This function calculates the length (in characters) of the common
+// suffix between two strings. It needs the calculated common prefix.
+template <bool MASKED>
+static size_t suffix_match(char_t const* const reference,
+                           size_t const        reference_length,
+                           char_t const* const sample,
+                           size_t const        sample_length,
+                           size_t const        prefix)
 {
   size_t i = 0;
 
   // Start at the end of both strings and traverse towards the start
   // as long as their characters are equal. Do not exceed the length
   // of the strings.
-  while (i < reference_length - prefix && i < sample_length - prefix && reference[reference_length - i - 1] == sample[sample_length - i - 1] && reference[reference_length - i - 1] != MASK)
+  while (i < reference_length - prefix && i < sample_length - prefix && reference[reference_length - i - 1] == sample[sample_length - i - 1] && unmasked<MASKED>(reference[reference_length - i - 1]))
   {
     ++i;
   } // while
   return i;
 } // suffix_match
 
+// The suffix_match function for arbitrary (possibly masked) strings.
+size_t suffix_match(char_t const* const reference,
+                    size_t const        reference_length,
+                    char_t const* const sample,
+                    size_t const        sample_length,
+                    size_t const        prefix)
+{
+  return suffix_match<true>(reference, reference_length, sample, sample_length, prefix);
+} // suffix_match
+
+// This function determines the variability of an insertion or
+// deletion. It is sufficient to check whether ``aW'' matches ``Wa''
+// (with ``a'' a character and ``W'' a word) when rolling towards the
+// start, and vice versa.
+void roll(position_t         &shift5,
+          position_t         &shift3,
+          char_t const* const string,
+          size_t const        length,
+          size_t const        start,
+          size_t const        end)
+{
+  shift5 = 0;
+  shift3 = 0;
+  if (start >= end)
+  {
+    return;
+  } // if
+
+  while (shift5 < start && string[start - shift5 - 1] == string[end - shift5 - 1])
+  {
+    ++shift5;
+  } // while
+  while (end + shift3 < length && string[end + shift3] == string[start + shift3])
+  {
+    ++shift3;
+  } // while
+  return;
+} // roll
+
 // This function converts a IUPAC Nucleotide Acid Notation into its
 // complement.
 char_t IUPAC_base_complement(char_t const base)
@@ -1538,18 +4173,96 @@ char_t const* IUPAC_complement(char_t const* const string,
   return complement;
 } // IUPAC_complement
 
-void backtranslation(char_t              ref_DNA[],
-                     char_t              alt_DNA[],
-                     char_t const* const reference,
-                     size_t const        reference_start,
-                     char_t const* const sample,
-                     size_t const        sample_start,
-                     size_t const        length,
-                     uint8_t const       type)
+// This function converts a (possibly ambiguous) IUPAC Nucleotide Acid
+// Notation symbol in either case into its complement.
+static char_t IUPAC_ambiguous_complement(char_t const base)
+{
+  switch (base)
+  {
+    case 'A':
+      return 'T';
+    case 'C':
+      return 'G';
+    case 'G':
+      return 'C';
+    case 'T':
+    case 'U':
+      return 'A';
+    case 'M':
+      return 'K';
+    case 'K':
+      return 'M';
+    case 'R':
+      return 'Y';
+    case 'Y':
+      return 'R';
+    case 'B':
+      return 'V';
+    case 'V':
+      return 'B';
+    case 'D':
+      return 'H';
+    case 'H':
+      return 'D';
+    case 'a':
+      return 't';
+    case 'c':
+      return 'g';
+    case 'g':
+      return 'c';
+    case 't':
+    case 'u':
+      return 'a';
+    case 'm':
+      return 'k';
+    case 'k':
+      return 'm';
+    case 'r':
+      return 'y';
+    case 'y':
+      return 'r';
+    case 'b':
+      return 'v';
+    case 'v':
+      return 'b';
+    case 'd':
+      return 'h';
+    case 'h':
+      return 'd';
+  } // switch
+  return base;
+} // IUPAC_ambiguous_complement
+
+// This function calculates the length of the reverse complement
+// palindromic prefix (and suffix) of a string. Only the first half
+// of the string needs to be checked.
+size_t palindrome_prefix(char_t const* const string,
+                         size_t const        start,
+                         size_t const        end)
 {
-  size_t reference_DNA[3 * length];
-  size_t sample_DNA[3 * length];
-  for (size_t i = 0; i < 3 * length; i++)
+  size_t const half = (end - start + 1) / 2;
+  for (size_t i = 0; i < half; ++i)
+  {
+    if (string[start + i] != IUPAC_ambiguous_complement(string[end - i - 1]))
+    {
+      return i;
+    } // if
+  } // for
+  return 0;
+} // palindrome_prefix
+
+void backtranslation(char_t                       reference_DNA[],
+                     char_t                       sample_DNA[],
+                     char_t const* const          reference,
+                     size_t const                 reference_start,
+                     char_t const* const          sample,
+                     size_t const                 sample_start,
+                     size_t const                 length,
+                     uint8_t const                type,
+                     Backtranslation_Table const& backtranslation_table)
+{
+  // The nucleotide bitmasks are gathered in the output buffers.
+  for (size_t i = 0; i < 3 * length; ++i)
   {
     reference_DNA[i] = 0;
     sample_DNA[i] = 0;
@@ -1557,97 +4270,92 @@ void backtranslation(char_t              ref_DNA[],
 
   for (size_t p = 0; p < length; ++p)
   {
-    for (size_t i = 0; i < 64; ++i)
+    uint8_t const reference_1 = backtranslation_table.acid_code[reference[reference_start + p] & 0x7f];
+    uint8_t const reference_2 = backtranslation_table.acid_code[reference[reference_start + p + 1] & 0x7f];
+    uint32_t const (&forward)[4] = backtranslation_table.backtranslation[reference_1][reference_2][backtranslation_table.acid_code[sample[sample_start + p] & 0x7f]];
+    uint8_t const sample_reverse = backtranslation_table.acid_code[sample[sample_start + length - p - 1] & 0x7f];
+    uint32_t const (&reverse)[4] = backtranslation_table.backtranslation[reference_1][reference_2][sample_reverse];
+
+    // Codon unions for the sample at p (forward) and at the mirrored
+    // position (reverse); the reference part is always at p.
+    uint32_t codon_forward = 0;
+    uint32_t codon_reverse = 0;
+    if ((type & FRAME_SHIFT_1) == FRAME_SHIFT_1)
     {
-      if (((acid_map[reference[reference_start + p] & 0x7f] >> i) & 0x1ull) == 0x1ull)
-      {
-        size_t const codon_reverse = ((i >> 0x4) | (i & 0xc) | ((i & 0x3) << 0x4)) ^ 0x3f;
-        for (size_t k = 0; k < 64; ++k)
-        {
-          if (((acid_map[sample[sample_start + length - p - 1] & 0x7f] >> k) & 0x1ull) == 0x1ull)
-          {
-            if ((type & FRAME_SHIFT_REVERSE) == FRAME_SHIFT_REVERSE && codon_reverse == k)
-            {
-              reference_DNA[p * 3] |= 0x1 << (i >> 4);
-              reference_DNA[p * 3 + 1] |= 0x1 << ((i >> 2) & 0x3);
-              reference_DNA[p * 3 + 2] |= 0x1 << (i & 0x3);
-              sample_DNA[(length - p) * 3 - 3] |= 0x1 << (codon_reverse >> 4);
-              sample_DNA[(length - p) * 3 - 2] |= 0x1 << ((codon_reverse >> 2) & 0x3);
-              sample_DNA[(length - p) * 3 - 1] |= 0x1 << (codon_reverse & 0x3);
-            } // if
-          } // if
-        } // for
-
-        for (size_t j = 0; j < 64; ++j)
-        {
-          if (((acid_map[reference[reference_start + p + 1] & 0x7f] >> j) & 0x1ull) == 0x1ull)
-          {
-            size_t const codon_1 = ((i & 0x3) << 0x4) | ((j & 0x3c) >> 0x2);
-            size_t const codon_2 = ((i & 0xf) << 0x2) | (j >> 0x4);
-            size_t const codon_reverse_1 = (((i & 0xc) >> 0x2) | ((i & 0x3) << 0x2) | (j & 0x30)) ^ 0x3f;
-            size_t const codon_reverse_2 = ((i & 0x3) | ((j & 0x30) >> 0x2) | ((j & 0xc) << 0x2)) ^ 0x3f;
-
-            for (size_t k = 0; k < 64; ++k)
-            {
-              if (((acid_map[sample[sample_start + p] & 0x7f] >> k) & 0x1ull) == 0x1ull)
-              {
-                if ((type & FRAME_SHIFT_1) == FRAME_SHIFT_1 && codon_1 == k)
-                {
-                  reference_DNA[p * 3] |= 0x1 << (i >> 4);
-                  reference_DNA[p * 3 + 1] |= 0x1 << ((i >> 2) & 0x3);
-                  reference_DNA[p * 3 + 2] |= 0x1 << (i & 0x3);
-                  sample_DNA[p * 3] |= 0x1 << (codon_1 >> 4);
-                  sample_DNA[p * 3 + 1] |= 0x1 << ((codon_1 >> 2) & 0x3);
-                  sample_DNA[p * 3 + 2] |= 0x1 << (codon_1 & 0x3);
-                } // if
-                if ((type & FRAME_SHIFT_2) == FRAME_SHIFT_2 && codon_2 == k)
-                {
-                  reference_DNA[p * 3] |= 0x1 << (i >> 4);
-                  reference_DNA[p * 3 + 1] |= 0x1 << ((i >> 2) & 0x3);
-                  reference_DNA[p * 3 + 2] |= 0x1 << (i & 0x3);
-                  sample_DNA[p * 3] |= 0x1 << (codon_2 >> 4);
-                  sample_DNA[p * 3 + 1] |= 0x1 << ((codon_2 >> 2) & 0x3);
-                  sample_DNA[p * 3 + 2] |= 0x1 << (codon_2 & 0x3);
-                } // if
-              } // if
+      codon_forward |= forward[0];
+    } // if
+    if ((type & FRAME_SHIFT_2) == FRAME_SHIFT_2)
+    {
+      codon_forward |= forward[1];
+    } // if
+    if ((type & FRAME_SHIFT_REVERSE) == FRAME_SHIFT_REVERSE)
+    {
+      codon_reverse |= backtranslation_table.backtranslation_reverse[reference_1][sample_reverse];
+    } // if
+    if ((type & FRAME_SHIFT_REVERSE_1) == FRAME_SHIFT_REVERSE_1)
+    {
+      codon_reverse |= reverse[2];
+    } // if
+    if ((type & FRAME_SHIFT_REVERSE_2) == FRAME_SHIFT_REVERSE_2)
+    {
+      codon_reverse |= reverse[3];
+    } // if
 
-              if (((acid_map[sample[sample_start + length - p - 1] & 0x7f] >> k) & 0x1ull) == 0x1ull)
-              {
-                if ((type & FRAME_SHIFT_REVERSE_1) == FRAME_SHIFT_REVERSE_1 && codon_reverse_1 == k)
-                {
-                  reference_DNA[p * 3] |= 0x1 << (i >> 4);
-                  reference_DNA[p * 3 + 1] |= 0x1 << ((i >> 2) & 0x3);
-                  reference_DNA[p * 3 + 2] |= 0x1 << (i & 0x3);
-                  sample_DNA[(length - p) * 3 - 3] |= 0x1 << (codon_reverse_1 >> 4);
-                  sample_DNA[(length - p) * 3 - 2] |= 0x1 << ((codon_reverse_1 >> 2) & 0x3);
-                  sample_DNA[(length - p) * 3 - 1] |= 0x1 << (codon_reverse_1 & 0x3);
-                } // if
-                if ((type & FRAME_SHIFT_REVERSE_2) == FRAME_SHIFT_REVERSE_2 && codon_reverse_2 == k)
-                {
-                  reference_DNA[p * 3] |= 0x1 << (i >> 4);
-                  reference_DNA[p * 3 + 1] |= 0x1 << ((i >> 2) & 0x3);
-                  reference_DNA[p * 3 + 2] |= 0x1 << (i & 0x3);
-                  sample_DNA[(length - p) * 3 - 3] |= 0x1 << (codon_reverse_2 >> 4);
-                  sample_DNA[(length - p) * 3 - 2] |= 0x1 << ((codon_reverse_2 >> 2) & 0x3);
-                  sample_DNA[(length - p) * 3 - 1] |= 0x1 << (codon_reverse_2 & 0x3);
-                } // if
-              } // if
-            } // for
-          } // if
-        } // for
-      } // if
+    uint32_t const codon_reference = codon_forward | codon_reverse;
+    for (size_t i = 0; i < 3; ++i)
+    {
+      reference_DNA[p * 3 + i] |= (codon_reference >> (4 * i)) & 0xf;
+      sample_DNA[p * 3 + i] |= (codon_forward >> (12 + 4 * i)) & 0xf;
+      sample_DNA[(length - p) * 3 - 3 + i] |= (codon_reverse >> (12 + 4 * i)) & 0xf;
     } // for
   } // for
-  for (size_t i = 0; i < 3 * length; i++)
+
+  for (size_t i = 0; i < 3 * length; ++i)
   {
-    ref_DNA[i] = IUPAC_ALPHA[reference_DNA[i]];
-    alt_DNA[i] = IUPAC_ALPHA[sample_DNA[i]];
+    reference_DNA[i] = IUPAC_ALPHA[static_cast<size_t>(reference_DNA[i])];
+    sample_DNA[i] = IUPAC_ALPHA[static_cast<size_t>(sample_DNA[i])];
   } // for
   return;
 } // backtranslation
 
-static void initialize_acid_frequency(void)
+// The nucleotides are mapped to their index in the codon string;
+// any other character is mapped to 64 so that the combined codon
+// index is out of range.
+size_t translate(char_t              protein[],
+                 char_t const* const DNA,
+                 size_t const        start,
+                 size_t const        end,
+                 char_t const* const codon_string)
+{
+  uint8_t nucleotide[256];
+  for (size_t i = 0; i < 256; ++i)
+  {
+    nucleotide[i] = 64;
+  } // for
+  nucleotide['A'] = nucleotide['a'] = 0;
+  nucleotide['C'] = nucleotide['c'] = 1;
+  nucleotide['G'] = nucleotide['g'] = 2;
+  nucleotide['T'] = nucleotide['t'] = 3;
+  nucleotide['U'] = nucleotide['u'] = 3;
+
+  size_t const length = (end - start) / 3;
+  uint8_t const* codon = reinterpret_cast<uint8_t const*>(DNA + start);
+  for (size_t i = 0; i < length; ++i, codon += 3)
+  {
+    size_t const index = 16 * nucleotide[codon[0]] + 4 * nucleotide[codon[1]] + nucleotide[codon[2]];
+    protein[i] = index < 64 ? codon_string[index] : 'X';
+  } // for
+  return length;
+} // translate
+
+// The relative frequencies of the amino acids (indexed by the lower
+// 127 ASCII characters).
+static constexpr void initialize_acid_frequency(double acid_frequency[128])
 {
+  for (size_t i = 0; i < 128; ++i)
+  {
+    acid_frequency[i] = .0f;
+  } // for
   acid_frequency['A'] = .09515673f;
   acid_frequency['C'] = .01157279f;
   acid_frequency['D'] = .05151007f;
@@ -1673,18 +4381,47 @@ static void initialize_acid_frequency(void)
   return;
 } // initialize_acid_frequency
 
-// This function precalculates the frame_shift_map and frequency count
-// based on a given codon string.
-void initialize_frame_shift_map(char_t const* const codon_string)
+// This function does the actual precalculation of the frame shift
+// tables. It can be evaluated at compile time for the built-in codon
+// tables.
+static constexpr void prepare_codon_table(Codon_Table         &codon_table,
+                                          char_t const* const codon_string)
 {
+  uint8_t (&acid_code)[128] = codon_table.acid_code;
+  uint64_t (&acid_map)[32] = codon_table.acid_map;
+  uint8_t (&frame_shift_map)[32][32][32] = codon_table.frame_shift_map;
+  uint8_t (&frame_shift_count)[32][32][5] = codon_table.frame_shift_count;
+  float (&frame_shift_frequency)[32][32][5] = codon_table.frame_shift_frequency;
+
+  // The amino acids actually used in the codon string get a compact
+  // code (in ASCII order); all other symbols share code 0. Amino acids
+  // beyond the 31st are treated as unknown.
+  bool present[128] = {false};
   for (size_t i = 0; i < 64; ++i)
   {
-    acid_map[i] = 0x0ull;
+    present[codon_string[i] & 0x7f] = true;
   } // for
+  size_t acid[32] = {0};
+  size_t acids = 1;
   for (size_t i = 0; i < 128; ++i)
   {
-    for (size_t j = 0; j < 128; ++j)
+    acid_code[i] = 0;
+    if (present[i] && acids < 32)
     {
+      acid[acids] = i;
+      acid_code[i] = static_cast<uint8_t>(acids++);
+    } // if
+  } // for
+
+  for (size_t i = 0; i < 32; ++i)
+  {
+    acid_map[i] = 0x0ull;
+    for (size_t j = 0; j < 32; ++j)
+    {
+      for (size_t k = 0; k < 32; ++k)
+      {
+        frame_shift_map[i][j][k] = FRAME_SHIFT_NONE;
+      } // for
       for (size_t k = 0; k < 5; ++k)
       {
         frame_shift_count[i][j][k] = 0;
@@ -1692,78 +4429,342 @@ void initialize_frame_shift_map(char_t const* const codon_string)
       } // for
     } // for
   } // for
-  initialize_acid_frequency();
+  double acid_frequency[128] = {.0f};
+  initialize_acid_frequency(acid_frequency);
   for (size_t i = 0; i < 64; ++i)
   {
-    acid_map[codon_string[i] & 0x7f] |= (0x1ull << i);
+    size_t const code = acid_code[codon_string[i] & 0x7f];
+    if (code != 0)
+    {
+      acid_map[code] |= (0x1ull << i);
+    } // if
   } // for
-  for (size_t i = 0; i < 128; ++i)
+
+  // Enumerate all combinations of two codons (for the two reference
+  // amino acids) once and scatter the resulting frame shifts to the
+  // amino acid of every shifted codon (the sample amino acid). This
+  // is equivalent to calling calculate_frame_shift for all
+  // combinations of three amino acids.
+  uint8_t codon_code[64] = {0};
+  for (size_t i = 0; i < 64; ++i)
+  {
+    codon_code[i] = acid_code[codon_string[i] & 0x7f];
+  } // for
+  for (size_t i = 0; i < 64; ++i)
+  {
+    size_t const codon_reverse = ((i >> 0x4) | (i & 0xc) | ((i & 0x3) << 0x4)) ^ 0x3f;
+    for (size_t j = 0; j < 64; ++j)
+    {
+      if (codon_code[i] == 0 || codon_code[j] == 0)
+      {
+        continue;
+      } // if
+      uint8_t (&shift)[32] = frame_shift_map[codon_code[i]][codon_code[j]];
+      size_t const codon_1 = ((i & 0x3) << 0x4) | ((j & 0x3c) >> 0x2);
+      size_t const codon_2 = ((i & 0xf) << 0x2) | (j >> 0x4);
+      size_t const codon_reverse_1 = (((i & 0xc) >> 0x2) | ((i & 0x3) << 0x2) | (j & 0x30)) ^ 0x3f;
+      size_t const codon_reverse_2 = ((i & 0x3) | ((j & 0x30) >> 0x2) | ((j & 0xc) << 0x2)) ^ 0x3f;
+      shift[codon_code[codon_1]] |= FRAME_SHIFT_1;
+      shift[codon_code[codon_2]] |= FRAME_SHIFT_2;
+      shift[codon_code[codon_reverse]] |= FRAME_SHIFT_REVERSE;
+      shift[codon_code[codon_reverse_1]] |= FRAME_SHIFT_REVERSE_1;
+      shift[codon_code[codon_reverse_2]] |= FRAME_SHIFT_REVERSE_2;
+    } // for
+  } // for
+  // Unknown sample amino acids never match.
+  for (size_t i = 0; i < 32; ++i)
+  {
+    for (size_t j = 0; j < 32; ++j)
+    {
+      frame_shift_map[i][j][0] = FRAME_SHIFT_NONE;
+    } // for
+  } // for
+
+  // Frequency count of the frame shifts (summed in double precision).
+  for (size_t i = 1; i < acids; ++i)
   {
-    if (acid_map[i] != 0x0ull)
+    for (size_t j = 1; j < acids; ++j)
     {
-      for (size_t j = 0; j < 128; ++j)
+      double frequency[5] = {.05f, .05f, .05f, .05f, .05f};
+      for (size_t k = 1; k < acids; ++k)
       {
-        if (acid_map[j] != 0x0ull)
+        uint8_t const shift = frame_shift_map[i][j][k];
+        for (size_t f = 0; f < 5; ++f)
         {
-          for (size_t k = 0; k < 128; ++k)
+          if (((shift >> f) & 0x1) == 0x1)
           {
-            if (acid_map[k] != 0x0ull)
-            {
-              uint8_t const shift = calculate_frame_shift(i, j, k);
-              frame_shift_map[i][j][k] = shift;
+            ++frame_shift_count[i][j][f];
+            frequency[f] += acid_frequency[acid[k]];
+          } // if
+        } // for
+      } // for
+      for (size_t f = 0; f < 5; ++f)
+      {
+        frame_shift_frequency[i][j][f] = static_cast<float>(frequency[f]);
+      } // for
+    } // for
+  } // for
+  return;
+} // prepare_codon_table
 
-              if ((shift & FRAME_SHIFT_1) == FRAME_SHIFT_1)
-              {
-                ++frame_shift_count[i][j][0];
-                frame_shift_frequency[i][j][0] += acid_frequency[k];
-              } // if
-              if ((shift & FRAME_SHIFT_2) == FRAME_SHIFT_2)
-              {
-                ++frame_shift_count[i][j][1];
-                frame_shift_frequency[i][j][1] += acid_frequency[k];
-              } // if
-              if ((shift & FRAME_SHIFT_REVERSE) == FRAME_SHIFT_REVERSE)
-              {
-                ++frame_shift_count[i][j][2];
-                frame_shift_frequency[i][j][2] += acid_frequency[k];
-              } // if
-              if ((shift & FRAME_SHIFT_REVERSE_1) == FRAME_SHIFT_REVERSE_1)
-              {
-                ++frame_shift_count[i][j][3];
-                frame_shift_frequency[i][j][3] += acid_frequency[k];
-              } // if
-              if ((shift & FRAME_SHIFT_REVERSE_2) == FRAME_SHIFT_REVERSE_2)
-              {
-                ++frame_shift_count[i][j][4];
-                frame_shift_frequency[i][j][4] += acid_frequency[k];
-              } // if
+// Calculates a complete codon table at compile time.
+static constexpr Codon_Table built_in_codon_table(char_t const* const codon_string)
+{
+  Codon_Table codon_table = Codon_Table();
+  prepare_codon_table(codon_table, codon_string);
+  return codon_table;
+} // built_in_codon_table
+
+// The codon tables of the NCBI translation tables are calculated at
+// compile time and stored in read-only memory. The codon strings are
+// as constructed by util.codon_table_string. Tables 27, 28 and 31 are
+// not included: some of their codons are both a stop codon and an
+// amino acid (depending on the context), which a codon string cannot
+// express. Other codon strings are prepared at run time.
+static constexpr char_t BUILT_IN_CODON_STRING[][65] =
+{
+  "KNKNTTTTRSRSIIMIQHQHPPPPRRRRLLLLEDEDAAAAGGGGVVVV*Y*YSSSS*CWCLFLF", //  1, 11
+  "KNKNTTTT*S*SMIMIQHQHPPPPRRRRLLLLEDEDAAAAGGGGVVVV*Y*YSSSSWCWCLFLF", //  2
+  "KNKNTTTTRSRSMIMIQHQHPPPPRRRRTTTTEDEDAAAAGGGGVVVV*Y*YSSSSWCWCLFLF", //  3
+  "KNKNTTTTRSRSIIMIQHQHPPPPRRRRLLLLEDEDAAAAGGGGVVVV*Y*YSSSSWCWCLFLF", //  4
+  "KNKNTTTTSSSSMIMIQHQHPPPPRRRRLLLLEDEDAAAAGGGGVVVV*Y*YSSSSWCWCLFLF", //  5
+  "KNKNTTTTRSRSIIMIQHQHPPPPRRRRLLLLEDEDAAAAGGGGVVVVQYQYSSSS*CWCLFLF", //  6
+  "NNKNTTTTSSSSIIMIQHQHPPPPRRRRLLLLEDEDAAAAGGGGVVVV*Y*YSSSSWCWCLFLF", //  9
+  "KNKNTTTTRSRSIIMIQHQHPPPPRRRRLLLLEDEDAAAAGGGGVVVV*Y*YSSSSCCWCLFLF", // 10
+  "KNKNTTTTRSRSIIMIQHQHPPPPRRRRLLSLEDEDAAAAGGGGVVVV*Y*YSSSS*CWCLFLF", // 12
+  "KNKNTTTTGSGSMIMIQHQHPPPPRRRRLLLLEDEDAAAAGGGGVVVV*Y*YSSSSWCWCLFLF", // 13
+  "NNKNTTTTSSSSIIMIQHQHPPPPRRRRLLLLEDEDAAAAGGGGVVVVYY*YSSSSWCWCLFLF", // 14
+  "KNKNTTTTRSRSIIMIQHQHPPPPRRRRLLLLEDEDAAAAGGGGVVVV*YQYSSSS*CWCLFLF", // 15
+  "KNKNTTTTRSRSIIMIQHQHPPPPRRRRLLLLEDEDAAAAGGGGVVVV*YLYSSSS*CWCLFLF", // 16
+  "NNKNTTTTSSSSMIMIQHQHPPPPRRRRLLLLEDEDAAAAGGGGVVVV*Y*YSSSSWCWCLFLF", // 21
+  "KNKNTTTTRSRSIIMIQHQHPPPPRRRRLLLLEDEDAAAAGGGGVVVV*YLY*SSS*CWCLFLF", // 22
+  "KNKNTTTTRSRSIIMIQHQHPPPPRRRRLLLLEDEDAAAAGGGGVVVV*Y*YSSSS*CWC*FLF", // 23
+  "KNKNTTTTSSKSIIMIQHQHPPPPRRRRLLLLEDEDAAAAGGGGVVVV*Y*YSSSSWCWCLFLF", // 24
+  "KNKNTTTTRSRSIIMIQHQHPPPPRRRRLLLLEDEDAAAAGGGGVVVV*Y*YSSSSGCWCLFLF", // 25
+  "KNKNTTTTRSRSIIMIQHQHPPPPRRRRLLALEDEDAAAAGGGGVVVV*Y*YSSSS*CWCLFLF", // 26
+  "KNKNTTTTRSRSIIMIQHQHPPPPRRRRLLLLEDEDAAAAGGGGVVVVYYYYSSSS*CWCLFLF", // 29
+  "KNKNTTTTRSRSIIMIQHQHPPPPRRRRLLLLEDEDAAAAGGGGVVVVEYEYSSSS*CWCLFLF", // 30
+  "KNKNTTTTRSRSIIMIQHQHPPPPRRRRLLLLEDEDAAAAGGGGVVVV*YWYSSSS*CWCLFLF", // 32
+  "KNKNTTTTSSKSIIMIQHQHPPPPRRRRLLLLEDEDAAAAGGGGVVVVYY*YSSSSWCWCLFLF"  // 33
+}; // BUILT_IN_CODON_STRING
+
+static size_t const BUILT_IN_CODON_TABLES = sizeof(BUILT_IN_CODON_STRING) / sizeof(BUILT_IN_CODON_STRING[0]);
+
+static constexpr Codon_Table BUILT_IN_CODON_TABLE[BUILT_IN_CODON_TABLES] =
+{
+  built_in_codon_table(BUILT_IN_CODON_STRING[0]),
+  built_in_codon_table(BUILT_IN_CODON_STRING[1]),
+  built_in_codon_table(BUILT_IN_CODON_STRING[2]),
+  built_in_codon_table(BUILT_IN_CODON_STRING[3]),
+  built_in_codon_table(BUILT_IN_CODON_STRING[4]),
+  built_in_codon_table(BUILT_IN_CODON_STRING[5]),
+  built_in_codon_table(BUILT_IN_CODON_STRING[6]),
+  built_in_codon_table(BUILT_IN_CODON_STRING[7]),
+  built_in_codon_table(BUILT_IN_CODON_STRING[8]),
+  built_in_codon_table(BUILT_IN_CODON_STRING[9]),
+  built_in_codon_table(BUILT_IN_CODON_STRING[10]),
+  built_in_codon_table(BUILT_IN_CODON_STRING[11]),
+  built_in_codon_table(BUILT_IN_CODON_STRING[12]),
+  built_in_codon_table(BUILT_IN_CODON_STRING[13]),
+  built_in_codon_table(BUILT_IN_CODON_STRING[14]),
+  built_in_codon_table(BUILT_IN_CODON_STRING[15]),
+  built_in_codon_table(BUILT_IN_CODON_STRING[16]),
+  built_in_codon_table(BUILT_IN_CODON_STRING[17]),
+  built_in_codon_table(BUILT_IN_CODON_STRING[18]),
+  built_in_codon_table(BUILT_IN_CODON_STRING[19]),
+  built_in_codon_table(BUILT_IN_CODON_STRING[20]),
+  built_in_codon_table(BUILT_IN_CODON_STRING[21]),
+  built_in_codon_table(BUILT_IN_CODON_STRING[22])
+}; // BUILT_IN_CODON_TABLE
+
+// This function returns the prepared codon table for a given codon
+// string. The tables are calculated only once per codon string (or
+// at compile time for the built-in codon tables).
+Codon_Table const* get_codon_table(char_t const* const codon_string)
+{
+  for (size_t i = 0; i < BUILT_IN_CODON_TABLES; ++i)
+  {
+    if (string_match(BUILT_IN_CODON_STRING[i], codon_string, 64))
+    {
+      return &BUILT_IN_CODON_TABLE[i];
+    } // if
+  } // for
 
-            } // if
-          } // for
-        } // if
-      } // for
+  // Lock-free lookup of an already prepared codon table.
+  for (Codon_Table_Entry const* entry = codon_table_cache.load(std::memory_order_acquire); entry != 0; entry = entry->next)
+  {
+    if (string_match(entry->codon_string, codon_string, 64))
+    {
+      return &entry->codon_table;
+    } // if
+  } // for
+
+  std::lock_guard<std::mutex> const lock(codon_table_mutex);
+
+  // Another thread might have prepared it in the meantime.
+  Codon_Table_Entry const* const head = codon_table_cache.load(std::memory_order_acquire);
+  for (Codon_Table_Entry const* entry = head; entry != 0; entry = entry->next)
+  {
+    if (string_match(entry->codon_string, codon_string, 64))
+    {
+      return &entry->codon_table;
     } // if
   } // for
+
+  // The entries live as long as the library.
+  Codon_Table_Entry* const entry = new Codon_Table_Entry();
+  for (size_t i = 0; i < 64; ++i)
+  {
+    entry->codon_string[i] = codon_string[i];
+  } // for
+  initialize_frame_shift_map(entry->codon_table, codon_string);
+  entry->next = head;
+  codon_table_cache.store(entry, std::memory_order_release);
+
+  return &entry->codon_table;
+} // get_codon_table
+
+// This function precalculates the frame_shift_map and frequency count
+// based on a given codon string.
+void initialize_frame_shift_map(Codon_Table         &codon_table,
+                                char_t const* const codon_string)
+{
+  prepare_codon_table(codon_table, codon_string);
   return;
 } // initialize_frame_shift_map
 
-// Used to precalculate the frame_shift_map. It computes for all
-// combinations of two reference amino acids the corresponding DNA
+// This function precalculates the codon unions used in the
+// backtranslation by enumerating all combinations of two codons (with
+// the amino acid codes of the codon table).
+static void prepare_backtranslation_table(Backtranslation_Table &backtranslation_table,
+                                          Codon_Table const&     codon_table,
+                                          char_t const* const    codon_string)
+{
+  for (size_t i = 0; i < 128; ++i)
+  {
+    backtranslation_table.acid_code[i] = codon_table.acid_code[i];
+  } // for
+  uint8_t codon_code[64] = {0};
+  for (size_t i = 0; i < 64; ++i)
+  {
+    codon_code[i] = codon_table.acid_code[codon_string[i] & 0x7f];
+  } // for
+
+  uint32_t (&backtranslation)[32][32][32][4] = backtranslation_table.backtranslation;
+  uint32_t (&backtranslation_reverse)[32][32] = backtranslation_table.backtranslation_reverse;
+  for (size_t i = 0; i < 32; ++i)
+  {
+    for (size_t j = 0; j < 32; ++j)
+    {
+      backtranslation_reverse[i][j] = 0;
+      for (size_t k = 0; k < 32; ++k)
+      {
+        for (size_t f = 0; f < 4; ++f)
+        {
+          backtranslation[i][j][k][f] = 0;
+        } // for
+      } // for
+    } // for
+  } // for
+  uint32_t nucleotides[64] = {0};
+  for (size_t i = 0; i < 64; ++i)
+  {
+    nucleotides[i] = (0x1 << (i >> 0x4)) | (0x10 << ((i >> 0x2) & 0x3)) | (0x100 << (i & 0x3));
+  } // for
+  for (size_t i = 0; i < 64; ++i)
+  {
+    if (codon_code[i] == 0)
+    {
+      continue;
+    } // if
+    size_t const codon_reverse = ((i >> 0x4) | (i & 0xc) | ((i & 0x3) << 0x4)) ^ 0x3f;
+    if (codon_code[codon_reverse] != 0)
+    {
+      backtranslation_reverse[codon_code[i]][codon_code[codon_reverse]] |= nucleotides[i] | (nucleotides[codon_reverse] << 12);
+    } // if
+    for (size_t j = 0; j < 64; ++j)
+    {
+      if (codon_code[j] == 0)
+      {
+        continue;
+      } // if
+      uint32_t (&codon_union)[32][4] = backtranslation[codon_code[i]][codon_code[j]];
+      size_t const codon[4] =
+      {
+        ((i & 0x3) << 0x4) | ((j & 0x3c) >> 0x2),
+        ((i & 0xf) << 0x2) | (j >> 0x4),
+        (((i & 0xc) >> 0x2) | ((i & 0x3) << 0x2) | (j & 0x30)) ^ 0x3f,
+        ((i & 0x3) | ((j & 0x30) >> 0x2) | ((j & 0xc) << 0x2)) ^ 0x3f
+      };
+      for (size_t f = 0; f < 4; ++f)
+      {
+        if (codon_code[codon[f]] != 0)
+        {
+          codon_union[codon_code[codon[f]]][f] |= nucleotides[i] | (nucleotides[codon[f]] << 12);
+        } // if
+      } // for
+    } // for
+  } // for
+  return;
+} // prepare_backtranslation_table
+
+// This function returns the backtranslation table for a given codon
+// string. The tables are calculated only once per codon string.
+Backtranslation_Table const* get_backtranslation_table(char_t const* const codon_string)
+{
+  // Lock-free lookup of an already prepared backtranslation table.
+  for (Backtranslation_Table_Entry const* entry = backtranslation_table_cache.load(std::memory_order_acquire); entry != 0; entry = entry->next)
+  {
+    if (string_match(entry->codon_string, codon_string, 64))
+    {
+      return &entry->backtranslation_table;
+    } // if
+  } // for
+
+  std::lock_guard<std::mutex> const lock(backtranslation_table_mutex);
+
+  // Another thread might have prepared it in the meantime.
+  Backtranslation_Table_Entry const* const head = backtranslation_table_cache.load(std::memory_order_acquire);
+  for (Backtranslation_Table_Entry const* entry = head; entry != 0; entry = entry->next)
+  {
+    if (string_match(entry->codon_string, codon_string, 64))
+    {
+      return &entry->backtranslation_table;
+    } // if
+  } // for
+
+  // The entries live as long as the library.
+  Backtranslation_Table_Entry* const entry = new Backtranslation_Table_Entry();
+  for (size_t i = 0; i < 64; ++i)
+  {
+    entry->codon_string[i] = codon_string[i];
+  } // for
+  prepare_backtranslation_table(entry->backtranslation_table, *get_codon_table(codon_string), codon_string);
+  entry->next = head;
+  backtranslation_table_cache.store(entry, std::memory_order_release);
+
+  return &entry->backtranslation_table;
+} // get_backtranslation_table
+
+// Calculates a single entry of the frame_shift_map. It computes for
+// all combinations of two reference amino acids the corresponding DNA
 // sequence and the (partial) overlap between all possible DNA
-// sequences of the sample amico acid.
-uint8_t calculate_frame_shift(size_t const reference_1,
-                              size_t const reference_2,
-                              size_t const sample)
+// sequences of the sample amico acid. The initialize_frame_shift_map
+// function constructs the same map by codon enumeration.
+uint8_t calculate_frame_shift(size_t const       reference_1,
+                              size_t const       reference_2,
+                              size_t const       sample,
+                              Codon_Table const& codon_table)
 {
   uint8_t shift = FRAME_SHIFT_NONE;
   for (size_t i = 0; i < 64; ++i)
   {
-    if (((acid_map[reference_1] >> i) & 0x1ull) == 0x1ull)
+    if (((codon_table.acid_map[reference_1] >> i) & 0x1ull) == 0x1ull)
     {
       size_t const codon_reverse = ((i >> 0x4) | (i & 0xc) | ((i & 0x3) << 0x4)) ^ 0x3f;
       for (size_t j = 0; j < 64; ++j)
       {
-        if (((acid_map[reference_2] >> j) & 0x1ull) == 0x1ull)
+        if (((codon_table.acid_map[reference_2] >> j) & 0x1ull) == 0x1ull)
         {
           size_t const codon_1 = ((i & 0x3) << 0x4) | ((j & 0x3c) >> 0x2);
           size_t const codon_2 = ((i & 0xf) << 0x2) | (j >> 0x4);
@@ -1771,7 +4772,7 @@ uint8_t calculate_frame_shift(size_t const reference_1,
           size_t const codon_reverse_2 = ((i & 0x3) | ((j & 0x30) >> 0x2) | ((j & 0xc) << 0x2)) ^ 0x3f;
           for (size_t k = 0; k < 64; ++k)
           {
-            if (((acid_map[sample] >> k) & 0x1ull) == 0x1ull)
+            if (((codon_table.acid_map[sample] >> k) & 0x1ull) == 0x1ull)
             {
               if (codon_1 == k)
               {
@@ -1805,13 +4806,46 @@ uint8_t calculate_frame_shift(size_t const reference_1,
 // This function calculates the frame shift. A reference amino acid is
 // checked against two possible partial overlaps between every
 // combination of two sample (observed) amino acids.
-uint8_t frame_shift(char_t const reference_1,
-                    char_t const reference_2,
-                    char_t const sample)
+uint8_t frame_shift(char_t const       reference_1,
+                    char_t const       reference_2,
+                    char_t const       sample,
+                    Codon_Table const& codon_table)
 {
-  return frame_shift_map[reference_1 & 0x7f][reference_2 & 0x7f][sample & 0x7f];
+  return codon_table.frame_shift_map[codon_table.acid_code[reference_1 & 0x7f]][codon_table.acid_code[reference_2 & 0x7f]][codon_table.acid_code[sample & 0x7f]];
 } // frame_shift
 
+// This function calculates the frame shift log probability prefix
+// sums along (a range of) the reference string. The frame shift
+// frequencies depend on two consecutive reference amino acids (both
+// the same for FRAME_SHIFT_REVERSE); beyond the end of the reference
+// no amino acid is known.
+void frame_shift_log_probability(double              log_probability[],
+                                 char_t const* const reference,
+                                 size_t const        reference_start,
+                                 size_t const        reference_end,
+                                 size_t const        reference_length,
+                                 Codon_Table const&  codon_table)
+{
+  for (size_t c = 0; c < 5; ++c)
+  {
+    log_probability[5 * reference_start + c] = .0f;
+  } // for
+  for (size_t p = reference_start; p < reference_end; ++p)
+  {
+    uint8_t const reference_1 = codon_table.acid_code[reference[p] & 0x7f];
+    uint8_t const reference_2 = p + 1 < reference_length ? codon_table.acid_code[reference[p + 1] & 0x7f] : 0;
+    float const (&frequency)[5] = codon_table.frame_shift_frequency[reference_1][reference_2];
+    double const* const previous = log_probability + 5 * p;
+    double* const current = log_probability + 5 * (p + 1);
+    current[0] = previous[0] + log(static_cast<double>(frequency[0]));
+    current[1] = previous[1] + log(static_cast<double>(frequency[1]));
+    current[2] = previous[2] + log(static_cast<double>(codon_table.frame_shift_frequency[reference_1][reference_1][2]));
+    current[3] = previous[3] + log(static_cast<double>(frequency[3]));
+    current[4] = previous[4] + log(static_cast<double>(frequency[4]));
+  } // for
+  return;
+} // frame_shift_log_probability
+
 
 #if defined(__debug__)
 // Debug function for printing large strings in truncated form: a
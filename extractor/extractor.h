@@ -15,7 +15,9 @@
 
 #include <cmath>
 #include <cstddef>
+#include <cstdint>
 #include <cstdlib>
+#include <string>
 #include <vector>
 
 
@@ -37,8 +39,25 @@ typedef char char_t;
 
 
 // Integer types of fixed bit width used for frame shift calculation.
-typedef unsigned char       uint8_t;
-typedef unsigned long long uint64_t;
+// These are the standard types (not new typedefs), so they do not
+// clash with the global ones in code using this namespace.
+using std::uint8_t;
+using std::uint16_t;
+using std::uint32_t;
+using std::uint64_t;
+
+
+// The integer type used for the positions (and lengths) stored in the
+// Variant, Substring, Repeat and Protein_Segment structures and the
+// LCS matrices. By default it is a size_t. Compiling with
+// -D__position32__ selects a 32-bit integer instead, which (nearly)
+// halves the size of these structures; all strings (and their concatenations)
+// must then be shorter than 4 Gb.
+#if defined(__position32__)
+typedef uint32_t position_t;
+#else
+typedef size_t   position_t;
+#endif
 
 
 // *******************************************************************
@@ -94,8 +113,9 @@ static uint8_t const FRAME_SHIFT_REVERSE_2 = 0x10;
 // characters used. The weight_position variable is used to have a
 // constant weight for a position description regardless the actual
 // position. It is usually set to ceil(log10(|reference| / 4)), and
-// its intention is to be constant during an extraction run.
-extern size_t       weight_position;
+// its intention is to be constant during an extraction run (it is
+// local to the thread doing the extraction).
+extern thread_local size_t weight_position;
 
 static size_t const WEIGHT_BASE               = 1; // i.e., A, C, G, T
 static size_t const WEIGHT_DELETION           = 3; // i.e., del
@@ -113,11 +133,40 @@ static size_t const WEIGHT_SUBSTITUTION       = 1; // i.e., >
 static size_t const THRESHOLD_CUT_OFF     = 16000;
 static double const TRANSPOSITION_CUT_OFF =   0.1;
 
+// The LCS_1 function (for strings other than DNA/RNA) only visits the
+// matching cells of the dynamic programming matrix (reference length
+// times sample length) if it has at least LCS_SPARSE_THRESHOLD cells
+// and at most one in LCS_SPARSE_DENSITY cells is a match. It switches
+// to a linear time algorithm instead if the matrix exceeds
+// LCS_SUFFIX_AUTOMATON_THRESHOLD cells and the matches are not also
+// sparse compared to its transition table (by the same
+// LCS_SPARSE_DENSITY). The suffix automaton has a dense
+// transition table (a 32-bit word per state and symbol), so it is
+// only used for references with a small alphabet (e.g., proteins)
+// shorter than LCS_SUFFIX_AUTOMATON_LENGTH.
+static size_t const LCS_SUFFIX_AUTOMATON_THRESHOLD =       4096;
+static size_t const LCS_SUFFIX_AUTOMATON_SYMBOLS   =         32;
+static size_t const LCS_SUFFIX_AUTOMATON_LENGTH    = 0x80000000;
+static size_t const LCS_SPARSE_THRESHOLD           =        256;
+static size_t const LCS_SPARSE_DENSITY             =          4;
+
+// The frame shift annotation of a protein extraction is done in
+// parallel if the total size of the substitutions (reference length
+// times sample length) exceeds this threshold.
+static size_t const FRAME_SHIFT_PARALLEL_THRESHOLD = 65536;
+
+// The frame shift annotation calculates the frame shifted runs of at
+// least this length only once for all levels of its recursion.
+// Shorter frame shifts are calculated by the dynamic programming of
+// the LCS_frame_shift function.
+static size_t const FRAME_SHIFT_RUN_LENGTH = 6;
+
 
 // This global variable is used to have access to the whole reference
 // string at any point in the extraction process. Commonly used in
-// transposition extraction.
-extern size_t global_reference_length;
+// transposition extraction (local to the thread doing the
+// extraction).
+extern thread_local size_t global_reference_length;
 
 
 // *******************************************************************
@@ -136,25 +185,46 @@ extern size_t global_reference_length;
 //                 constants above
 //   @member weight: weight of the variant according to the weight
 //                   constants above (used internally)
+//   @member probability: (in union with @member weight) probability
+//                        of a frame shift annotation (always a
+//                        double: long frame shifts have probabilities
+//                        far below the range of a float)
 //   @member transposition_start: starting position of a transposition
 //                                within the reference string
 //   @member transposition_end: ending position of a transposition
 //                              within the reference string
+//   @member shift5: number of positions an insertion (deletion) can be
+//                   shifted towards the start of the sample (reference)
+//                   string (see roll)
+//   @member shift3: number of positions an insertion (deletion) can be
+//                   shifted towards the end of the sample (reference)
+//                   string (see roll)
+//   @member palindrome: (in union with @member shift5) length of the
+//                       reverse complement palindromic prefix of an
+//                       inversion (see palindrome_prefix); only an
+//                       inversion can have a palindromic prefix and
+//                       it can never be shifted
 // *******************************************************************
 struct Variant
 {
-  size_t       reference_start;
-  size_t       reference_end;
-  size_t       sample_start;
-  size_t       sample_end;
+  position_t   reference_start;
+  position_t   reference_end;
+  position_t   sample_start;
+  position_t   sample_end;
   unsigned int type;
   union
   {
-    size_t     weight;
+    position_t weight;
     double     probability;
   }; // union
-  size_t       transposition_start;
-  size_t       transposition_end;
+  position_t   transposition_start;
+  position_t   transposition_end;
+  union
+  {
+    position_t shift5;
+    position_t palindrome;
+  }; // union
+  position_t   shift3;
 
   inline Variant(size_t const       reference_start,
                  size_t const       reference_end,
@@ -171,11 +241,21 @@ struct Variant
          type(type),
          weight(weight),
          transposition_start(transposition_start),
-         transposition_end(transposition_end) { }
+         transposition_end(transposition_end),
+         shift5(0),
+         shift3(0) { }
 
   inline Variant(void) { }
 }; // Variant
 
+// A variant takes ten 64-bit words (on 64-bit platforms), six with
+// __position32__ (the probability is a double in both layouts).
+#if defined(__position32__)
+static_assert(sizeof(Variant) == 48, "unexpected size of Variant");
+#else
+static_assert(sizeof(size_t) != 8 || sizeof(Variant) == 80, "unexpected size of Variant");
+#endif
+
 // *******************************************************************
 // Variant_List structure
 //   This structure describes a list of variants with associated
@@ -190,6 +270,180 @@ struct Variant_List
   std::vector<Variant> variants;
 }; // Variant_List
 
+// *******************************************************************
+// Translated_Variant_List structure
+//   This structure describes a list of variants between two
+//   translated DNA strings with associated metadata.
+//
+//   @member reference: reference protein string (translated)
+//   @member sample: sample protein string (translated)
+//   @member weight_position: weight used for position descriptors
+//   @member variants: vector of variants (on the protein strings)
+// *******************************************************************
+struct Translated_Variant_List
+{
+  std::string          reference;
+  std::string          sample;
+  size_t               weight_position;
+  std::vector<Variant> variants;
+}; // Translated_Variant_List
+
+// *******************************************************************
+// Masked_Repeat structure
+//   This structure describes a masked repeat: a number of consecutive
+//   occurrences of a repeat unit.
+//
+//   @member start: starting position of the repeat within the string
+//   @member count: number of consecutive occurrences of the unit
+//   @member unit: index of the repeat unit (see mask_repeats)
+// *******************************************************************
+struct Masked_Repeat
+{
+  position_t start;
+  position_t count;
+  position_t unit;
+}; // Masked_Repeat
+
+// *******************************************************************
+// Masked_String structure
+//   This structure describes a string in which repeat units are
+//   masked.
+//
+//   @member string: masked string
+//   @member repeats: vector of masked repeats (ordered by position)
+// *******************************************************************
+struct Masked_String
+{
+  std::string                string;
+  std::vector<Masked_Repeat> repeats;
+}; // Masked_String
+
+// *******************************************************************
+// Repeat structure
+//   This structure describes a short tandem repeat (or the region
+//   between two repeats).
+//
+//   @member start: starting position of the repeat unit
+//   @member end: ending position of the repeat unit
+//   @member count: number of repetitions following the unit (0 for a
+//                  region between two repeats)
+// *******************************************************************
+struct Repeat
+{
+  position_t start;
+  position_t end;
+  position_t count;
+
+  inline Repeat(size_t const start,
+                size_t const end,
+                size_t const count = 0):
+         start(start),
+         end(end),
+         count(count) { }
+
+  inline Repeat(void) { }
+}; // Repeat
+
+// *******************************************************************
+// Protein_Segment structure
+//   This structure describes a part of the inserted sample string of
+//   a protein variant: either a frame shift annotation or the
+//   (unannotated) sample string in between.
+//
+//   @member reference_start: starting position of the frame shift
+//                            within the reference string
+//   @member reference_end: ending position of the frame shift within
+//                          the reference string
+//   @member sample_start: starting position of the part within the
+//                         sample string
+//   @member sample_end: ending position of the part within the sample
+//                       string
+//   @member frames: frame shift types (1, 2, inv, 1inv, 2inv), empty
+//                   for an unannotated part
+// *******************************************************************
+struct Protein_Segment
+{
+  position_t               reference_start;
+  position_t               reference_end;
+  position_t               sample_start;
+  position_t               sample_end;
+  std::vector<std::string> frames;
+}; // Protein_Segment
+
+// *******************************************************************
+// Protein_Variant structure
+//   This structure describes a variant between two protein strings
+//   with its inserted sample string split into frame shift segments.
+//
+//   @member variant: the variant
+//   @member segments: vector of segments (ordered by position)
+// *******************************************************************
+struct Protein_Variant
+{
+  Variant                      variant;
+  std::vector<Protein_Segment> segments;
+}; // Protein_Variant
+
+// *******************************************************************
+// Codon_Table structure
+//   This structure contains the precalculated frame shift tables for
+//   a given codon string. Once prepared it is never modified, so it
+//   can be shared between (concurrent) extractions.
+//
+//   All tables are indexed by a compact amino acid code (at most 31
+//   distinct amino acids; code 0 is used for all symbols not present
+//   in the codon string), so the tables fit in the (L1) cache.
+//
+//   @member acid_code: the compact code of every amino acid (indexed
+//                      by the lower 127 ASCII characters)
+//   @member acid_map: for every amino acid code a bitmask of its
+//                     codons
+//   @member frame_shift_map: the frame shift for all combinations of
+//                            two reference amino acids and a sample
+//                            amino acid
+//   @member frame_shift_count: a frequency count of all possible
+//                              frame shifts (5) for all combinations
+//                              of two amino acids
+//   @member frame_shift_frequency: used to calculate the frame shift
+//                                  probability
+// *******************************************************************
+struct Codon_Table
+{
+  uint8_t  acid_code[128];
+  uint64_t acid_map[32];
+  uint8_t  frame_shift_map[32][32][32];
+  uint8_t  frame_shift_count[32][32][5];
+  float    frame_shift_frequency[32][32][5];
+}; // Codon_Table
+
+// *******************************************************************
+// Backtranslation_Table structure
+//   This structure contains the precalculated codon unions used in the
+//   backtranslation of frame shifts. It is only calculated on first
+//   use (see get_backtranslation_table) and it is indexed by the same
+//   compact amino acid code as the Codon_Table.
+//
+//   @member acid_code: the compact code of every amino acid (indexed
+//                      by the lower 127 ASCII characters)
+//   @member backtranslation: for all combinations of two reference
+//                            amino acids, a sample amino acid and the
+//                            frame shifts FRAME_SHIFT_1,
+//                            FRAME_SHIFT_2, FRAME_SHIFT_REVERSE_1 and
+//                            FRAME_SHIFT_REVERSE_2 the union of all
+//                            possible codons of the first reference
+//                            amino acid (bits 0--11) and of the
+//                            sample amino acid (bits 12--23) as three
+//                            nucleotide bitmasks (A, C, G, T)
+//   @member backtranslation_reverse: idem for FRAME_SHIFT_REVERSE
+//                                    (only one reference amino acid)
+// *******************************************************************
+struct Backtranslation_Table
+{
+  uint8_t  acid_code[128];
+  uint32_t backtranslation[32][32][32][4];
+  uint32_t backtranslation_reverse[32][32];
+}; // Backtranslation_Table
+
 // *******************************************************************
 // extract function
 //   This function is the interface function for Python. It is just a
@@ -205,14 +459,292 @@ struct Variant_List
 //   @arg codon_string: serialized codon table: 64 characters
 //                      corresponding to the codons AAA, ..., TTT.
 //                      Only for protein extraction (frame shifts).
+//   @arg annotate: calculate the frame shift annotation (protein
+//                  extraction only), see also annotate_frame_shift
+//   @arg annotation_threads: number of threads for the frame shift
+//                            annotation (0 --- number of cores), see
+//                            also extract below
 //   @return: variant list with metadata
 // *******************************************************************
 Variant_List extract(char_t const* const reference,
+                     size_t const        reference_length,
+                     char_t const* const sample,
+                     size_t const        sample_length,
+                     int const           type               = TYPE_DNA,
+                     char_t const* const codon_string       = 0,
+                     bool const          annotate           = true,
+                     size_t const        annotation_threads = 1);
+
+// The number of fields of a serialized variant (see
+// serialize_variants).
+static size_t const VARIANT_RECORD_FIELDS = 11;
+
+// *******************************************************************
+// serialize_variants function
+//   Serializes a vector of variants into records of eleven 64-bit
+//   unsigned integers (native byte order) for bulk transfer, e.g., as
+//   a numpy structured array. The fields of a record are:
+//     0 reference_start      4 type                    8 shift5
+//     1 reference_end        5 weight (the bits of     9 shift3
+//     2 sample_start           the double             10 palindrome
+//     3 sample_end             probability for frame     (the same as
+//                              shift annotation, in      shift5)
+//                              both layouts)
+//                            6 transposition_start
+//                            7 transposition_end
+//
+//   @arg record: output buffer (VARIANT_RECORD_FIELDS * number of
+//                variants)
+//   @arg variant: vector of variants
+// *******************************************************************
+void serialize_variants(uint64_t                    record[],
+                        std::vector<Variant> const &variant);
+
+// *******************************************************************
+// describe_dna_allele function
+//   This function formats the extracted variants of two DNA/RNA
+//   strings as an HGVS allele description, e.g., [3dup;8G>T;12del].
+//   Insertions and deletions are shifted towards the end of the
+//   string, duplications are recognized, inversions are trimmed to
+//   their palindromic prefix and transpositions are described by
+//   their (inverted) reference ranges.
+//
+//   A variant that lies (after shifting) outside the strings raises
+//   std::out_of_range.
+//
+//   @arg reference: reference string
+//   @arg reference_length: length of the reference string
+//   @arg sample: sample string
+//   @arg sample_length: length of the sample string
+//   @arg variant: the extracted variants (see extract)
+//   @return: the HGVS allele description (= if there are no variants)
+// *******************************************************************
+std::string describe_dna_allele(char_t const* const         reference,
+                                size_t const                reference_length,
+                                char_t const* const         sample,
+                                size_t const                sample_length,
+                                std::vector<Variant> const &variant);
+
+// *******************************************************************
+// group_protein_variants function
+//   This function groups the variants extracted from two protein
+//   strings: every variant (other than an identity) with the frame
+//   shift annotations following it. The parts of the sample string
+//   between the annotations are added as unannotated segments.
+//
+//   @arg variant: the extracted variants (see extract)
+//   @return: the protein variants (in order)
+// *******************************************************************
+std::vector<Protein_Variant> group_protein_variants(std::vector<Variant> const &variant);
+
+// *******************************************************************
+// mask_repeats function
+//   This function masks all (non-overlapping) occurrences of the
+//   repeat units in a string with the MASK character. The units are
+//   masked in the given order, i.e., a unit can not occur within an
+//   already masked region, and their occurrences are found in one
+//   pass (Aho-Corasick). Adjacent occurrences are counted as one
+//   repeat.
+//
+//   @arg string: string to be masked
+//   @arg length: length of the string
+//   @arg unit: repeat units (in order of priority)
+//   @return: the masked string with its masked repeats
+// *******************************************************************
+Masked_String mask_repeats(char_t const* const             string,
+                           size_t const                    length,
+                           std::vector<std::string> const &unit);
+
+// *******************************************************************
+// split_masked_variants function
+//   This function splits the variants extracted from masked strings
+//   at the masked regions of the sample string. The reference (and
+//   transposition) positions of the split variants are offset,
+//   variants without masked regions are copied as is. A variant that
+//   lies outside the sample string raises std::out_of_range.
+//
+//   @arg sample: masked sample string (as extracted)
+//   @arg sample_length: length of the masked sample string
+//   @arg variant: the extracted variants (see extract)
+//   @arg reference_offset: offset of the masked reference string
+//   @return: the split variants
+// *******************************************************************
+std::vector<Variant> split_masked_variants(char_t const* const         sample,
+                                           size_t const                sample_length,
+                                           std::vector<Variant> const &variant,
+                                           size_t const                reference_offset);
+
+// *******************************************************************
+// short_tandem_repeats function
+//   This function extracts the short tandem repeat structure of a
+//   string. The string is scanned from start to end: at each position
+//   the unit with the most repetitions (the longest unit in case of a
+//   tie) is taken, after which the scan continues at the end of the
+//   repeat. The candidate units are found in the runs (maximal
+//   repetitions) of the string, which are calculated from its Lyndon
+//   words in O(n log n) time.
+//
+//   @arg string: string
+//   @arg length: length of the string
+//   @arg min_length: minimum length of a repeat unit
+//   @arg max_length: maximum length of a repeat unit (0 for no
+//                    maximum)
+//   @return: the repeats and the regions in between (in order)
+// *******************************************************************
+std::vector<Repeat> short_tandem_repeats(char_t const* const string,
+                                         size_t const        length,
+                                         size_t const        min_length = 1,
+                                         size_t const        max_length = 0);
+
+// *******************************************************************
+// extract_batch function
+//   This function is the interface function for Python to extract a
+//   batch of string pairs (e.g., all proteins of a proteome) in one
+//   call. The pairs are extracted in parallel and share one prepared
+//   codon table. Different numbers of reference and sample strings
+//   raise std::invalid_argument.
+//
+//   @arg reference: reference strings
+//   @arg sample: sample strings (paired with the reference strings)
+//   @arg type: type of strings  0 --- DNA/RNA (default)
+//                               1 --- Protein
+//                               2 --- Other
+//   @arg codon_string: serialized codon table: 64 characters
+//                      corresponding to the codons AAA, ..., TTT.
+//                      Only for protein extraction (frame shifts).
+//   @arg threads: number of threads (0 --- number of cores)
+//   @arg annotate: calculate the frame shift annotation (protein
+//                  extraction only)
+//   @return: variant lists with metadata (in order of the pairs)
+// *******************************************************************
+std::vector<Variant_List> extract_batch(std::vector<std::string> const& reference,
+                                        std::vector<std::string> const& sample,
+                                        int const                       type         = TYPE_DNA,
+                                        char_t const* const             codon_string = 0,
+                                        size_t const                    threads      = 0,
+                                        bool const                      annotate     = true);
+
+// *******************************************************************
+// Asynchronous extraction functions
+//   These functions are the interface functions for Python to extract
+//   string pairs asynchronously on an internal pool of worker threads
+//   (one per core). An extraction is identified by the number returned
+//   by extract_async. Completed extractions are signalled through a
+//   file descriptor that becomes readable (e.g., for an event loop).
+//   A forked child process starts with a new (empty) pool.
+// *******************************************************************
+
+// *******************************************************************
+// extract_async function
+//   Queues an extraction. The strings are copied, so they do not need
+//   to outlive the call.
+//
+//   @arg reference: reference string
+//   @arg reference_length: reference length
+//   @arg sample: sample string
+//   @arg sample_length: sample length
+//   @arg type: type of strings  0 --- DNA/RNA (default)
+//                               1 --- Protein
+//                               2 --- Other
+//   @arg codon_string: serialized codon table: 64 characters
+//                      corresponding to the codons AAA, ..., TTT.
+//                      Only for protein extraction (frame shifts).
+//   @arg annotate: calculate the frame shift annotation (protein
+//                  extraction only)
+//   @return: identifier of the extraction
+// *******************************************************************
+size_t extract_async(char_t const* const reference,
                      size_t const        reference_length,
                      char_t const* const sample,
                      size_t const        sample_length,
                      int const           type         = TYPE_DNA,
-                     char_t const* const codon_string = 0);
+                     char_t const* const codon_string = 0,
+                     bool const          annotate     = true);
+
+// *******************************************************************
+// extraction_fd function
+//   @return: file descriptor that is readable when extractions have
+//            completed (see completed_extractions), -1 on failure
+// *******************************************************************
+int extraction_fd(void);
+
+// *******************************************************************
+// completed_extractions function
+//   Clears the completion signal of the file descriptor.
+//
+//   @return: identifiers of the extractions completed since the
+//            previous call (of which the results are not yet taken)
+// *******************************************************************
+std::vector<size_t> completed_extractions(void);
+
+// *******************************************************************
+// extraction_done function
+//   @arg identifier: identifier of an extraction
+//   @return: true iff the extraction is completed
+// *******************************************************************
+bool extraction_done(size_t const identifier);
+
+// *******************************************************************
+// extraction_result function
+//   Waits for an extraction to complete and takes its result. The
+//   identifier is invalid afterwards. The exception of a failed
+//   extraction (e.g., std::bad_alloc) is rethrown. An invalid
+//   identifier (unknown or already taken) raises std::out_of_range.
+//
+//   @arg identifier: identifier of an extraction
+//   @return: variant list with metadata
+// *******************************************************************
+Variant_List extraction_result(size_t const identifier);
+
+// *******************************************************************
+// annotate_frame_shift function
+//   This function is the interface function for Python to calculate
+//   the frame shift annotation of a single substitution on demand,
+//   i.e., after a protein extraction without annotation. The result
+//   is the same as the annotation following the substitution in an
+//   annotated extraction.
+//
+//   @arg reference: reference string
+//   @arg reference_length: length of the reference string
+//   @arg sample: sample string
+//   @arg sample_length: length of the sample string
+//   @arg variant: substitution (other variants have no annotation)
+//   @arg codon_string: serialized codon table: 64 characters
+//                      corresponding to the codons AAA, ..., TTT.
+//   @return: frame shift annotation
+// *******************************************************************
+std::vector<Variant> annotate_frame_shift(char_t const* const reference,
+                                          size_t const        reference_length,
+                                          char_t const* const sample,
+                                          size_t const        sample_length,
+                                          Variant const&      variant,
+                                          char_t const* const codon_string);
+
+// *******************************************************************
+// extract_translated function
+//   This function is the interface function for Python to extract
+//   the protein variants between two coding DNA strings. Both strings
+//   are translated (see translate) and extracted as protein strings
+//   without leaving C++.
+//
+//   @arg reference: reference coding DNA string
+//   @arg reference_length: length of the reference string
+//   @arg sample: sample coding DNA string
+//   @arg sample_length: length of the sample string
+//   @arg codon_string: serialized codon table: 64 characters
+//                      corresponding to the codons AAA, ..., TTT.
+//   @arg annotate: calculate the frame shift annotation
+//   @arg annotation_threads: number of threads for the frame shift
+//                            annotation (0 --- number of cores)
+//   @return: translated strings and the variant list with metadata
+// *******************************************************************
+Translated_Variant_List extract_translated(char_t const* const reference,
+                                           size_t const        reference_length,
+                                           char_t const* const sample,
+                                           size_t const        sample_length,
+                                           char_t const* const codon_string,
+                                           bool const          annotate           = true,
+                                           size_t const        annotation_threads = 1);
 
 // *******************************************************************
 // extract function
@@ -232,6 +764,16 @@ Variant_List extract(char_t const* const reference,
 //   @arg codon_string: serialized codon table: 64 characters
 //                      corresponding to the codons AAA, ..., TTT.
 //                      Only for protein extraction (frame shifts).
+//   @arg annotate: calculate the frame shift annotation (protein
+//                  extraction only)
+//   @arg annotation_threads: number of threads for the frame shift
+//                            annotation (0 --- number of cores). A
+//                            single thread by default: the extraction
+//                            functions release the GIL, so they are
+//                            usually called from several (Python)
+//                            threads at once. Only used if the
+//                            substitutions exceed
+//                            FRAME_SHIFT_PARALLEL_THRESHOLD.
 //   @return: weight of the extracted variants
 // *******************************************************************
 size_t extract(std::vector<Variant> &variant,
@@ -239,8 +781,10 @@ size_t extract(std::vector<Variant> &variant,
                size_t const          reference_length,
                char_t const* const   sample,
                size_t const          sample_length,
-               int const             type         = TYPE_DNA,
-               char_t const* const   codon_string = 0);
+               int const             type               = TYPE_DNA,
+               char_t const* const   codon_string       = 0,
+               bool const            annotate           = true,
+               size_t const          annotation_threads = 1);
 
 // *******************************************************************
 // extractor function
@@ -329,9 +873,9 @@ size_t extractor_protein(std::vector<Variant> &variant,
 // extractor_frame_shift function
 //   This function extracts the frame shift annotation between the
 //   reference and the sample protein string by recursively calling
-//   itself on prefixes and suffixes of a longest common substring,
-//   calculated by the LCS_frame_shift algorithm (these strings are
-//   very short).
+//   itself on prefixes and suffixes of a longest common substring.
+//   The frame shifted runs are calculated once (LCS_frame_shift_runs)
+//   and shared by all prefixes and suffixes.
 //
 //   @arg annotation: vector of variants (contains annotation)
 //   @arg reference: reference string
@@ -340,6 +884,10 @@ size_t extractor_protein(std::vector<Variant> &variant,
 //   @arg sample: sample string
 //   @arg sample_start: starting position in the sample string
 //   @arg sample_end: ending position in the sample string
+//   @arg codon_table: prepared codon table
+//   @arg log_probability: frame shift log probability prefix sums of
+//                         the reference string (see
+//                         frame_shift_log_probability)
 // *******************************************************************
 void extractor_frame_shift(std::vector<Variant> &annotation,
                            char_t const* const   reference,
@@ -347,7 +895,9 @@ void extractor_frame_shift(std::vector<Variant> &annotation,
                            size_t const          reference_end,
                            char_t const* const   sample,
                            size_t const          sample_start,
-                           size_t const          sample_end);
+                           size_t const          sample_end,
+                           Codon_Table const&    codon_table,
+                           double const* const   log_probability);
 
 
 // *******************************************************************
@@ -373,13 +923,13 @@ void extractor_frame_shift(std::vector<Variant> &annotation,
 // *******************************************************************
 struct Substring
 {
-  size_t  reference_index;
-  size_t  sample_index;
-  size_t  length;
+  position_t reference_index;
+  position_t sample_index;
+  position_t length;
   union
   {
-    bool    reverse_complement;
-    uint8_t type;
+    bool       reverse_complement;
+    uint8_t    type;
   }; // union
 
   inline Substring(size_t const  reference_index,
@@ -437,7 +987,9 @@ size_t LCS(std::vector<Substring> &substring,
 //   This function calculates the longest common substrings between
 //   two (three?) strings. It asumes no similarity between both
 //   strings. Not for use for large strings. This is the classical
-//   dynamic programming algorithm.
+//   dynamic programming algorithm (large strings other than DNA/RNA
+//   with a small alphabet are handed to LCS_suffix_automaton, strings
+//   with only a few matches to LCS_1_sparse).
 //
 //   @arg substring: vector of substrings
 //   @arg reference: reference string
@@ -459,6 +1011,89 @@ size_t LCS_1(std::vector<Substring> &substring,
              size_t const            sample_start,
              size_t const            sample_end);
 
+// *******************************************************************
+// LCS_1_bit_parallel function
+//   This function calculates the longest common substrings between
+//   two (three?) strings exactly like the LCS_1 function (including
+//   the order of the resulting substrings), but computes 64 cells of
+//   the dynamic programming matrix at once using per-symbol match
+//   bitmasks. It is used by LCS_1 for DNA/RNA strings (small
+//   alphabet).
+//
+//   @arg substring: vector of substrings
+//   @arg reference: reference string
+//   @arg complement: complement string (can be null for strings other
+//                    than DNA/RNA)
+//   @arg reference_start: starting position in the reference string
+//   @arg reference_end: ending position in the reference string
+//   @arg sample: sample string
+//   @arg sample_start: starting position in the sample string
+//   @arg sample_end: ending position in the sample string
+//   @return: length of the LCS
+// *******************************************************************
+size_t LCS_1_bit_parallel(std::vector<Substring> &substring,
+                          char_t const* const     reference,
+                          char_t const* const     complement,
+                          size_t const            reference_start,
+                          size_t const            reference_end,
+                          char_t const* const     sample,
+                          size_t const            sample_start,
+                          size_t const            sample_end);
+
+// *******************************************************************
+// LCS_1_sparse function
+//   This function calculates the longest common substrings between
+//   two strings exactly like the LCS_1 function (including the order
+//   of the resulting substrings), but only visits the matching cells
+//   of the dynamic programming matrix. It is used by LCS_1 for strings
+//   other than DNA/RNA with only a few matches (large alphabets).
+//
+//   @arg substring: vector of substrings
+//   @arg reference: reference string
+//   @arg reference_start: starting position in the reference string
+//   @arg reference_end: ending position in the reference string
+//   @arg sample: sample string
+//   @arg sample_start: starting position in the sample string
+//   @arg sample_end: ending position in the sample string
+//   @return: length of the LCS
+// *******************************************************************
+size_t LCS_1_sparse(std::vector<Substring> &substring,
+                    char_t const* const     reference,
+                    size_t const            reference_start,
+                    size_t const            reference_end,
+                    char_t const* const     sample,
+                    size_t const            sample_start,
+                    size_t const            sample_end);
+
+// *******************************************************************
+// LCS_suffix_automaton function
+//   This function calculates the longest common substrings between
+//   two strings exactly like the LCS_1 function (including the order
+//   of the resulting substrings), but in linear time using a suffix
+//   automaton of the reference string. It is used by LCS_1 for large
+//   strings other than DNA/RNA with a small alphabet (e.g.,
+//   proteins). The reference string must be shorter than
+//   LCS_SUFFIX_AUTOMATON_LENGTH (the states are 32-bit) and its
+//   transition table takes 8 * LCS_SUFFIX_AUTOMATON_SYMBOLS bytes per
+//   reference character at most.
+//
+//   @arg substring: vector of substrings
+//   @arg reference: reference string
+//   @arg reference_start: starting position in the reference string
+//   @arg reference_end: ending position in the reference string
+//   @arg sample: sample string
+//   @arg sample_start: starting position in the sample string
+//   @arg sample_end: ending position in the sample string
+//   @return: length of the LCS
+// *******************************************************************
+size_t LCS_suffix_automaton(std::vector<Substring> &substring,
+                            char_t const* const     reference,
+                            size_t const            reference_start,
+                            size_t const            reference_end,
+                            char_t const* const     sample,
+                            size_t const            sample_start,
+                            size_t const            sample_end);
+
 // *******************************************************************
 // LCS_k function
 //   This function calculates the longest common substrings between
@@ -501,6 +1136,7 @@ size_t LCS_k(std::vector<Substring> &substring,
 //   @arg sample: sample string
 //   @arg sample_start: starting position in the sample string
 //   @arg sample_end: ending position in the sample string
+//   @arg codon_table: prepared codon table
 // *******************************************************************
 void LCS_frame_shift(std::vector<Substring> &substring,
                      char_t const* const     reference,
@@ -508,7 +1144,62 @@ void LCS_frame_shift(std::vector<Substring> &substring,
                      size_t const            reference_end,
                      char_t const* const     sample,
                      size_t const            sample_start,
-                     size_t const            sample_end);
+                     size_t const            sample_end,
+                     Codon_Table const&      codon_table);
+
+// *******************************************************************
+// LCS_frame_shift_runs function
+//   This function calculates all maximal frame shifted runs (the
+//   diagonals of the frame shift LCS matrix) of at least
+//   FRAME_SHIFT_RUN_LENGTH in a single pass. From these runs the frame
+//   shift LCS of any subrange can be calculated without recalculating
+//   the matrix (see LCS_frame_shift_clipped).
+//
+//   @arg run: vector of frame shifted runs (substrings with a single
+//             frame shift type)
+//   @arg reference: reference string
+//   @arg reference_start: starting position in the reference string
+//   @arg reference_end: ending position in the reference string
+//   @arg sample: sample string
+//   @arg sample_start: starting position in the sample string
+//   @arg sample_end: ending position in the sample string
+//   @arg codon_table: prepared codon table
+// *******************************************************************
+void LCS_frame_shift_runs(std::vector<Substring> &run,
+                          char_t const* const     reference,
+                          size_t const            reference_start,
+                          size_t const            reference_end,
+                          char_t const* const     sample,
+                          size_t const            sample_start,
+                          size_t const            sample_end,
+                          Codon_Table const&      codon_table);
+
+// *******************************************************************
+// LCS_frame_shift_clipped function
+//   This function calculates the frame shift LCS from the frame
+//   shifted runs. The longest frame shift LCSs are the same as
+//   calculated by the LCS_frame_shift function (which is used if no
+//   run is long enough).
+//
+//   @arg substring: vector of substrings
+//   @arg run: frame shifted runs clipped to the given ranges
+//   @arg reference: reference string
+//   @arg reference_start: starting position in the reference string
+//   @arg reference_end: ending position in the reference string
+//   @arg sample: sample string
+//   @arg sample_start: starting position in the sample string
+//   @arg sample_end: ending position in the sample string
+//   @arg codon_table: prepared codon table
+// *******************************************************************
+void LCS_frame_shift_clipped(std::vector<Substring>       &substring,
+                             std::vector<Substring> const &run,
+                             char_t const* const           reference,
+                             size_t const                  reference_start,
+                             size_t const                  reference_end,
+                             char_t const* const           sample,
+                             size_t const                  sample_start,
+                             size_t const                  sample_end,
+                             Codon_Table const&            codon_table);
 
 
 // *******************************************************************
@@ -586,6 +1277,29 @@ size_t suffix_match(char_t const* const reference,
                     size_t const        sample_length,
                     size_t const        prefix = 0);
 
+// *******************************************************************
+// roll function
+//   This function determines the variability of an insertion or
+//   deletion by looking at the cyclic permutations of the pattern,
+//   i.e., the number of positions the pattern can be shifted in either
+//   direction without changing the string.
+//
+//   @arg shift5: number of positions the pattern can be shifted
+//                towards the start of the string
+//   @arg shift3: number of positions the pattern can be shifted
+//                towards the end of the string
+//   @arg string: string containing the pattern
+//   @arg length: length of the string
+//   @arg start: starting position of the pattern in the string
+//   @arg end: ending position of the pattern in the string
+// *******************************************************************
+void roll(position_t         &shift5,
+          position_t         &shift3,
+          char_t const* const string,
+          size_t const        length,
+          size_t const        start,
+          size_t const        end);
+
 
 // *******************************************************************
 // IUPAC Nucleotide Acid Notation functions
@@ -620,36 +1334,86 @@ char_t IUPAC_complement(char_t const base);
 char_t const* IUPAC_complement(char_t const* const string,
                                size_t const        length);
 
+// *******************************************************************
+// palindrome_prefix function
+//   This function calculates the length of the reverse complement
+//   palindromic prefix (and suffix) of a string, e.g., 2 for TACGCTA.
+//   All (ambiguous) IUPAC Nucleotide Acid Notation symbols in either
+//   case are complemented.
+//
+//   @arg string: string in the IUPAC Nucleotide Acid Notation
+//                alphabet
+//   @arg start: starting position in the string
+//   @arg end: ending position in the string
+//   @return: the length of the palindromic prefix or 0 if the string
+//            equals its reverse complement
+// *******************************************************************
+size_t palindrome_prefix(char_t const* const string,
+                         size_t const        start,
+                         size_t const        end);
+
 
 // *******************************************************************
 // Amino Acid functions
 //   These functions are useful for calculating frame shifts.
 // *******************************************************************
 
+// *******************************************************************
+// get_codon_table function
+//   Returns the prepared codon table for a given codon string. The
+//   tables of the common NCBI genetic codes are calculated at compile
+//   time. Other tables are calculated on first use and cached for the
+//   lifetime of the library. Lookups of already prepared tables are
+//   lock-free.
+//
+//   @arg codon_string: gives the amino acid symbols in codon order:
+//                      0 AAA, ... 63 TTT.
+//   @return: prepared (immutable) codon table
+// *******************************************************************
+Codon_Table const* get_codon_table(char_t const* const codon_string);
+
+// *******************************************************************
+// get_backtranslation_table function
+//   Returns the backtranslation table for a given codon string. The
+//   tables are calculated on first use (also for the common NCBI
+//   genetic codes) and cached for the lifetime of the library.
+//
+//   @arg codon_string: gives the amino acid symbols in codon order:
+//                      0 AAA, ... 63 TTT.
+//   @return: prepared (immutable) backtranslation table
+// *******************************************************************
+Backtranslation_Table const* get_backtranslation_table(char_t const* const codon_string);
+
 // *******************************************************************
 // initialize_frame_shift_map function
-//   Precalculates the frame_shift_map based on a given codon string.
+//   Precalculates the frame_shift_map based on a given codon string
+//   by enumerating all combinations of two codons once.
 //
+//   @arg codon_table: codon table to be initialized
 //   @arg codon_string: gives the amino acid symbols in codon order:
 //                      0 AAA, ... 63 TTT.
 // *******************************************************************
-void initialize_frame_shift_map(char_t const* const codon_string);
+void initialize_frame_shift_map(Codon_Table         &codon_table,
+                                char_t const* const codon_string);
 
 // *******************************************************************
 // calculate_frame_shift function
-//   Used to precalculate the frame_shift_map. It computes for all
-//   combinations of two reference amino acids the corresponding DNA
-//   sequence and the (partial) overlap between all possible DNA
-//   sequences of the sample amico acid.
+//   Calculates a single entry of the frame_shift_map. It computes for
+//   all combinations of two reference amino acids the corresponding
+//   DNA sequence and the (partial) overlap between all possible DNA
+//   sequences of the sample amico acid. The frame_shift_map itself is
+//   constructed by codon enumeration in initialize_frame_shift_map.
 //
-//   @arg reference_1: first reference amino acid
-//   @arg reference_2: second reference amino acid
-//   @arg sample: sample amino acid
+//   @arg reference_1: first reference amino acid code
+//   @arg reference_2: second reference amino acid code
+//   @arg sample: sample amino acid code
+//   @arg codon_table: codon table (only the acid_map is used)
 //   @return: frame shift
 // *******************************************************************
-uint8_t calculate_frame_shift(size_t const reference_1,
-                              size_t const reference_2,
-                              size_t const sample);
+uint8_t calculate_frame_shift(size_t const       reference_1,
+                              size_t const       reference_2,
+                              size_t const       sample,
+                              Codon_Table const& codon_table);
 
 // *******************************************************************
 // frame_shift function
@@ -661,21 +1425,87 @@ uint8_t calculate_frame_shift(size_t const reference_1,
 //   @arg reference_1: first reference amino acid
 //   @arg reference_2: second reference amino acid
 //   @arg sample: sample amino acid
+//   @arg codon_table: prepared codon table
 //   @return: frame shift
 // *******************************************************************
-uint8_t frame_shift(char_t const reference_1,
-                    char_t const reference_2,
-                    char_t const sample);
+uint8_t frame_shift(char_t const       reference_1,
+                    char_t const       reference_2,
+                    char_t const       sample,
+                    Codon_Table const& codon_table);
+
+// *******************************************************************
+// frame_shift_log_probability function
+//   Calculates for every frame shift (5) the prefix sums of the
+//   logarithms of the frame shift frequencies along the reference
+//   string. The probability of a (non-compound) frame shift over any
+//   stretch of the reference is then found in constant time.
+//
+//   @arg log_probability: prefix sums (5 * (reference_length + 1))
+//                         with the prefix sum for position p and frame
+//                         shift c at 5 * p + c (only the range from
+//                         reference_start to reference_end is set)
+//   @arg reference: reference string
+//   @arg reference_start: starting position in the reference string
+//   @arg reference_end: ending position in the reference string
+//   @arg reference_length: length of the reference string
+//   @arg codon_table: prepared codon table
+// *******************************************************************
+void frame_shift_log_probability(double              log_probability[],
+                                 char_t const* const reference,
+                                 size_t const        reference_start,
+                                 size_t const        reference_end,
+                                 size_t const        reference_length,
+                                 Codon_Table const&  codon_table);
 
+// *******************************************************************
+// translate function
+//   Translates a DNA/RNA string into a protein string. Every codon is
+//   a single (scalar) lookup in the codon string: at about 1 ns per
+//   codon the translation is well below 1% of the extraction time,
+//   so a vectorized (gather) lookup does not pay off. Codons with
+//   other nucleotides than A, C, G, T/U (either case) translate to X.
+//   A trailing incomplete codon is ignored.
+//
+//   @arg protein: output buffer ((end - start) / 3) for the protein
+//   @arg DNA: DNA/RNA string
+//   @arg start: starting position in the DNA/RNA string
+//   @arg end: ending position in the DNA/RNA string
+//   @arg codon_string: serialized codon table: 64 characters
+//                      corresponding to the codons AAA, ..., TTT.
+//   @return: length of the protein string
+// *******************************************************************
+size_t translate(char_t              protein[],
+                 char_t const* const DNA,
+                 size_t const        start,
+                 size_t const        end,
+                 char_t const* const codon_string);
 
-void backtranslation(char_t             reference_DNA[],
-                     char_t             sample_DNA[],
-                     char_t const* const reference,
-                     size_t const        reference_start,
-                     char_t const* const sample,
-                     size_t const        sample_start,
-                     size_t const        length,
-                     uint8_t const       type);
+// *******************************************************************
+// backtranslation function
+//   Calculates the DNA sequences (in IUPAC Nucleotide Acid Notation)
+//   of the reference and the sample protein that explain a frame
+//   shift. Every position is a few lookups in the precalculated
+//   backtranslation table.
+//
+//   @arg reference_DNA: output buffer (3 * length) for the reference
+//   @arg sample_DNA: output buffer (3 * length) for the sample
+//   @arg reference: reference protein string
+//   @arg reference_start: starting position in the reference string
+//   @arg sample: sample protein string
+//   @arg sample_start: starting position in the sample string
+//   @arg length: length of the frame shift
+//   @arg type: frame shift type (FRAME_SHIFT constants)
+//   @arg backtranslation_table: prepared backtranslation table
+// *******************************************************************
+void backtranslation(char_t                       reference_DNA[],
+                     char_t                       sample_DNA[],
+                     char_t const* const          reference,
+                     size_t const                 reference_start,
+                     char_t const* const          sample,
+                     size_t const                 sample_start,
+                     size_t const                 length,
+                     uint8_t const                type,
+                     Backtranslation_Table const& backtranslation_table);
 
 
 #if defined(__debug__)
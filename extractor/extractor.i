@@ -10,16 +10,273 @@
 //   other languages than C/C++.
 // *******************************************************************
 
+%include "std_string.i"
 %include "std_vector.i"
 
-%module extractor
+%module(threads="1") extractor
 %{
 #include "extractor.h"
+
+#include <exception>
+#include <new>
+#include <stdexcept>
+
+// The variants as a bytes object of records (see serialize_variants),
+// filled directly from the vector.
+static PyObject* variants_buffer(std::vector<mutalyzer::Variant> const &variant)
+{
+  PyObject* const buffer = PyBytes_FromStringAndSize(0, variant.size() * mutalyzer::VARIANT_RECORD_FIELDS * sizeof(mutalyzer::uint64_t));
+  if (buffer != 0)
+  {
+    mutalyzer::serialize_variants(reinterpret_cast<mutalyzer::uint64_t*>(PyBytes_AS_STRING(buffer)), variant);
+  }
+  return buffer;
+}
 %}
 
+// Only the extraction functions release the GIL (see below).
+%nothread;
+
+// The reference and sample strings can be given as any object that
+// supports the buffer protocol (e.g., bytes, bytearray, mmap or a
+// numpy uint8 array). These are read in place (and pinned for the
+// duration of the call). The buffer must be C-contiguous with single
+// byte items. Other objects (unicode strings) are converted as usual.
+// The size of the buffer (or converted string) is kept to check the
+// given lengths against (see below).
+%typemap(in) char_t const* const reference, char_t const* const sample, char_t const* const string (Py_buffer view, int buffer = 0, char* string = 0, size_t length = 0, int alloc = 0, size_t size = 0)
+{
+  if (!PyUnicode_Check($input) && PyObject_CheckBuffer($input))
+  {
+    if (PyObject_GetBuffer($input, &view, PyBUF_STRIDES) != 0)
+    {
+      SWIG_fail;
+    }
+    buffer = 1;
+    if (!PyBuffer_IsContiguous(&view, 'C') || view.itemsize != 1)
+    {
+      PyErr_SetString(PyExc_ValueError, "in method '$symname', argument $argnum must be a C-contiguous buffer of single bytes");
+      SWIG_fail;
+    }
+    $1 = static_cast<char_t const*>(view.buf);
+    size = view.len;
+  }
+  else
+  {
+    int const result = SWIG_AsCharPtrAndSize($input, &string, &length, &alloc);
+    if (!SWIG_IsOK(result))
+    {
+      SWIG_exception_fail(SWIG_ArgError(result), "in method '$symname', argument $argnum of type 'char_t const *'");
+    }
+    $1 = string;
+    // The converted size includes the terminating null character.
+    size = length > 0 ? length - 1 : 0;
+  }
+}
+
+%typemap(freearg) char_t const* const reference, char_t const* const sample, char_t const* const string
+{
+  if (buffer$argnum)
+  {
+    PyBuffer_Release(&view$argnum);
+  }
+  if (alloc$argnum == SWIG_NEWOBJ)
+  {
+    delete[] string$argnum;
+  }
+}
+
+%typemap(typecheck, precedence=SWIG_TYPECHECK_STRING) char_t const* const reference, char_t const* const sample, char_t const* const string
+{
+  $1 = (!PyUnicode_Check($input) && PyObject_CheckBuffer($input)) || SWIG_IsOK(SWIG_AsCharPtrAndSize($input, 0, 0, 0)) ? 1 : 0;
+}
+
+// A length may not exceed the size of its string: the native code
+// does not check its reads.
+%typemap(check) (char_t const* const reference, size_t const reference_length), (char_t const* const sample, size_t const sample_length), (char_t const* const string, size_t const length)
+{
+  if ($2 > size$argnum)
+  {
+    PyErr_SetString(PyExc_ValueError, "in method '$symname', argument $argnum: the length exceeds the size of the string");
+    SWIG_fail;
+  }
+}
+
+// The containers (and variants) given to the functions that release
+// the GIL are copied while the GIL is still held: a proxy object could
+// otherwise be changed or freed by another thread during the call. A
+// container converted from a Python sequence is moved instead.
+%define %copied_container(TYPE, NAME)
+%typemap(in) TYPE const &NAME (TYPE value)
+{
+  TYPE* pointer = 0;
+  int const result = swig::asptr($input, &pointer);
+  if (!SWIG_IsOK(result) || pointer == 0)
+  {
+    SWIG_exception_fail(SWIG_ArgError(result), "in method '$symname', argument $argnum of type '$1_type'");
+  }
+  if (SWIG_IsNewObj(result))
+  {
+    value.swap(*pointer);
+    delete pointer;
+  }
+  else
+  {
+    value = *pointer;
+  }
+  $1 = &value;
+}
+
+%typemap(freearg) TYPE const &NAME ""
+%enddef
+
+%copied_container(std::vector<mutalyzer::Variant>, variant)
+%copied_container(std::vector<std::string>, reference)
+%copied_container(std::vector<std::string>, sample)
+%copied_container(std::vector<std::string>, unit)
+
+%typemap(in) mutalyzer::Variant const &variant (mutalyzer::Variant value, void* pointer = 0)
+{
+  int const result = SWIG_ConvertPtr($input, &pointer, $descriptor(mutalyzer::Variant*), 0);
+  if (!SWIG_IsOK(result))
+  {
+    SWIG_exception_fail(SWIG_ArgError(result), "in method '$symname', argument $argnum of type 'Variant const &'");
+  }
+  if (pointer == 0)
+  {
+    SWIG_exception_fail(SWIG_ValueError, "in method '$symname', invalid null reference of type 'Variant const &'");
+  }
+  value = *static_cast<mutalyzer::Variant*>(pointer);
+  $1 = &value;
+}
+
+// Variants that lie outside the strings they are described with are
+// rejected by the native code.
+%exception describe_dna_allele
+{
+  try
+  {
+    $action
+  }
+  catch (std::out_of_range const &error)
+  {
+    PyErr_SetString(PyExc_IndexError, error.what());
+    SWIG_fail;
+  }
+}
+
+%exception split_masked_variants
+{
+  try
+  {
+    $action
+  }
+  catch (std::out_of_range const &error)
+  {
+    PyErr_SetString(PyExc_IndexError, error.what());
+    SWIG_fail;
+  }
+}
+
+// The frame shift annotation may run on several threads; their
+// exceptions are propagated to the caller.
+%exception extract
+{
+  try
+  {
+    $action
+  }
+  catch (std::bad_alloc const &)
+  {
+    PyErr_NoMemory();
+    SWIG_fail;
+  }
+  catch (std::exception const &error)
+  {
+    PyErr_SetString(PyExc_RuntimeError, error.what());
+    SWIG_fail;
+  }
+}
+
+%exception extract_translated
+{
+  try
+  {
+    $action
+  }
+  catch (std::bad_alloc const &)
+  {
+    PyErr_NoMemory();
+    SWIG_fail;
+  }
+  catch (std::exception const &error)
+  {
+    PyErr_SetString(PyExc_RuntimeError, error.what());
+    SWIG_fail;
+  }
+}
+
+// The reference and sample strings of a batch are paired. A failing
+// extraction (or worker thread) fails the whole batch.
+%exception extract_batch
+{
+  try
+  {
+    $action
+  }
+  catch (std::invalid_argument const &error)
+  {
+    PyErr_SetString(PyExc_ValueError, error.what());
+    SWIG_fail;
+  }
+  catch (std::bad_alloc const &)
+  {
+    PyErr_NoMemory();
+    SWIG_fail;
+  }
+  catch (std::exception const &error)
+  {
+    PyErr_SetString(PyExc_RuntimeError, error.what());
+    SWIG_fail;
+  }
+}
+
+// The exception of a failed asynchronous extraction. An unknown
+// identifier (or one of which the result is already taken) raises a
+// KeyError.
+%exception extraction_result
+{
+  try
+  {
+    $action
+  }
+  catch (std::out_of_range const &error)
+  {
+    PyErr_SetString(PyExc_KeyError, error.what());
+    SWIG_fail;
+  }
+  catch (std::bad_alloc const &)
+  {
+    PyErr_NoMemory();
+    SWIG_fail;
+  }
+  catch (std::exception const &error)
+  {
+    PyErr_SetString(PyExc_RuntimeError, error.what());
+    SWIG_fail;
+  }
+}
+
 namespace std
 {
 %template(VariantVector) vector<mutalyzer::Variant>;
+%template(Variant_ListVector) vector<mutalyzer::Variant_List>;
+%template(StringVector) vector<string>;
+%template(Masked_RepeatVector) vector<mutalyzer::Masked_Repeat>;
+%template(RepeatVector) vector<mutalyzer::Repeat>;
+%template(SizeVector) vector<size_t>;
+%template(Protein_SegmentVector) vector<mutalyzer::Protein_Segment>;
+%template(Protein_VariantVector) vector<mutalyzer::Protein_Variant>;
 }
 
 namespace mutalyzer
@@ -29,6 +286,12 @@ static char const* const VERSION;
 
 typedef char char_t;
 
+#if defined(__position32__)
+typedef unsigned int position_t;
+#else
+typedef size_t       position_t;
+#endif
+
 static int const TYPE_DNA;
 static int const TYPE_PROTEIN;
 static int const TYPE_OTHER;
@@ -55,15 +318,20 @@ static size_t const WEIGHT_INVERSION;
 static size_t const WEIGHT_SEPARATOR;
 static size_t const WEIGHT_SUBSTITUTION;
 
+static size_t const VARIANT_RECORD_FIELDS;
+
 struct Variant
 {
-  size_t       reference_start;
-  size_t       reference_end;
-  size_t       sample_start;
-  size_t       sample_end;
+  position_t   reference_start;
+  position_t   reference_end;
+  position_t   sample_start;
+  position_t   sample_end;
   unsigned int type;
-  size_t       transposition_start;
-  size_t       transposition_end;
+  position_t   transposition_start;
+  position_t   transposition_end;
+  position_t   shift5;
+  position_t   shift3;
+  position_t   palindrome; // shares its storage with shift5
 };
 
 struct Variant_List
@@ -72,11 +340,144 @@ struct Variant_List
   std::vector<Variant> variants;
 };
 
+%extend Variant_List
+{
+  PyObject* variants_buffer()
+  {
+    return variants_buffer($self->variants);
+  }
+}
+
+struct Translated_Variant_List
+{
+  std::string          reference;
+  std::string          sample;
+  size_t               weight_position;
+  std::vector<Variant> variants;
+};
+
+%extend Translated_Variant_List
+{
+  PyObject* variants_buffer()
+  {
+    return variants_buffer($self->variants);
+  }
+}
+
+struct Masked_Repeat
+{
+  position_t start;
+  position_t count;
+  position_t unit;
+};
+
+struct Masked_String
+{
+  std::string                string;
+  std::vector<Masked_Repeat> repeats;
+};
+
+struct Repeat
+{
+  position_t start;
+  position_t end;
+  position_t count;
+
+  Repeat(size_t const start,
+         size_t const end,
+         size_t const count = 0);
+};
+
+struct Protein_Segment
+{
+  position_t               reference_start;
+  position_t               reference_end;
+  position_t               sample_start;
+  position_t               sample_end;
+  std::vector<std::string> frames;
+};
+
+struct Protein_Variant
+{
+  Variant                      variant;
+  std::vector<Protein_Segment> segments;
+};
+
+// The extraction functions release the GIL for the entire native
+// call. Their string arguments (and the buffers they pin) are kept
+// alive by the caller for the duration of the call, their containers
+// and variants are copied (see above).
+%thread;
+
 Variant_List extract(char_t const* const reference,
                      size_t const        reference_length,
                      char_t const* const sample,
                      size_t const        sample_length,
                      int const           type = TYPE_DNA,
-                     char_t const* const codon_string = 0);
+                     char_t const* const codon_string = 0,
+                     bool const          annotate = true,
+                     size_t const        annotation_threads = 1);
+
+std::vector<Variant_List> extract_batch(std::vector<std::string> const& reference,
+                                        std::vector<std::string> const& sample,
+                                        int const                       type = TYPE_DNA,
+                                        char_t const* const             codon_string = 0,
+                                        size_t const                    threads = 0,
+                                        bool const                      annotate = true);
+
+size_t extract_async(char_t const* const reference,
+                     size_t const        reference_length,
+                     char_t const* const sample,
+                     size_t const        sample_length,
+                     int const           type = TYPE_DNA,
+                     char_t const* const codon_string = 0,
+                     bool const          annotate = true);
+
+int extraction_fd(void);
+
+std::vector<size_t> completed_extractions(void);
+
+bool extraction_done(size_t const identifier);
+
+Variant_List extraction_result(size_t const identifier);
+
+std::vector<Variant> annotate_frame_shift(char_t const* const reference,
+                                          size_t const        reference_length,
+                                          char_t const* const sample,
+                                          size_t const        sample_length,
+                                          Variant const&      variant,
+                                          char_t const* const codon_string);
+
+Translated_Variant_List extract_translated(char_t const* const reference,
+                                           size_t const        reference_length,
+                                           char_t const* const sample,
+                                           size_t const        sample_length,
+                                           char_t const* const codon_string,
+                                           bool const          annotate = true,
+                                           size_t const        annotation_threads = 1);
+
+std::vector<Protein_Variant> group_protein_variants(std::vector<Variant> const &variant);
+
+std::string describe_dna_allele(char_t const* const         reference,
+                                size_t const                reference_length,
+                                char_t const* const         sample,
+                                size_t const                sample_length,
+                                std::vector<Variant> const &variant);
+
+Masked_String mask_repeats(char_t const* const             string,
+                           size_t const                    length,
+                           std::vector<std::string> const &unit);
+
+std::vector<Variant> split_masked_variants(char_t const* const         sample,
+                                           size_t const                sample_length,
+                                           std::vector<Variant> const &variant,
+                                           size_t const                reference_offset);
+
+std::vector<Repeat> short_tandem_repeats(char_t const* const string,
+                                         size_t const        length,
+                                         size_t const        min_length = 1,
+                                         size_t const        max_length = 0);
+
+%nothread;
 
 }
@@ -6,6 +6,7 @@ General utility definitions.
 from __future__ import (absolute_import, division, print_function,
     unicode_literals)
 
+import struct
 import sys
 
 from Bio.Data import CodonTable
@@ -30,10 +31,10 @@ def codon_table_string(table_id):
     :returns: String representation of code table referenced by {table_id}.
     :rtype: str
     """
-    codons = CodonTable.unambiguous_dna_by_id[table_id].forward_table.items()
+    codons = list(CodonTable.unambiguous_dna_by_id[table_id].forward_table.items())
 
-    codons += map(lambda x: (x, '*'),
-        CodonTable.unambiguous_dna_by_id[table_id].stop_codons)
+    codons += [(x, '*')
+        for x in CodonTable.unambiguous_dna_by_id[table_id].stop_codons]
 
     return ''.join(map(lambda x: x[1], sorted(codons)))
 
@@ -58,10 +59,18 @@ def swig_str(s, ascii_only=True):
     length of the unicode string directly. This assumption can be removed by
     specifying `ascii_only=False`.
 
+    Objects supporting the buffer protocol (e.g., bytes, bytearray, mmap or
+    a numpy uint8 array) are returned as is with their length in bytes: the
+    extractor reads them in place.
+
     http://www.swig.org/Doc2.0/SWIGDocumentation.html#Python_nn49
     https://github.com/swig/swig/blob/master/Lib/python/pystrings.swg
     http://comments.gmane.org/gmane.comp.programming.swig.devel/23268
     """
+    if not isinstance(s, str):
+        view = memoryview(s)
+        return s, len(view) * view.itemsize
+
     if PY2 or not ascii_only:
         s_encoded = s.encode('utf-8')
         if PY2:
@@ -71,6 +80,61 @@ def swig_str(s, ascii_only=True):
     return s, len(s)
 
 
+#: Fields of a serialized variant (see `Variant_List.variants_buffer`), all
+#: 64-bit unsigned integers in native byte order. For frame shift
+#: annotation the `weight` field holds the bits of the (double) probability.
+#: The `palindrome` field (inversions) shares its value with the `shift5`
+#: field (insertions and deletions).
+VARIANT_FIELDS = ('reference_start', 'reference_end', 'sample_start',
+    'sample_end', 'type', 'weight', 'transposition_start',
+    'transposition_end', 'shift5', 'shift3', 'palindrome')
+
+_VARIANT_STRUCT = struct.Struct(b'=11Q')
+
+
+class VariantRecord(object):
+    """
+    A (mutable) variant unpacked from a serialized variant list. It has the
+    same attributes as the variants of the extractor module.
+    """
+    __slots__ = VARIANT_FIELDS
+
+    def __init__(self, *fields):
+        for name, value in zip(VARIANT_FIELDS, fields):
+            setattr(self, name, value)
+
+
+def variant_records(extracted):
+    """
+    Iterate over the variants of an extracted variant list without a call
+    to the extractor module per variant.
+
+    :arg extracted: Variant list (the result of an extraction).
+
+    :returns: Iterator over `VariantRecord` objects.
+    """
+    buffer = extracted.variants_buffer()
+    for offset in range(0, len(buffer), _VARIANT_STRUCT.size):
+        yield VariantRecord(*_VARIANT_STRUCT.unpack_from(buffer, offset))
+
+
+def variants_array(extracted):
+    """
+    Return the variants of an extracted variant list as a numpy structured
+    array (with the fields in `VARIANT_FIELDS`). The array is a read-only
+    view on a single buffer filled by the extractor module. Requires numpy.
+
+    :arg extracted: Variant list (the result of an extraction).
+
+    :returns: numpy structured array.
+    """
+    import numpy
+
+    dtype = numpy.dtype([(name.encode('ascii') if PY2 else name, '=u8')
+        for name in VARIANT_FIELDS])
+    return numpy.frombuffer(extracted.variants_buffer(), dtype=dtype)
+
+
 #: Python 3 behaviour for `str` on both Python 2 and 3.
 str = unicode if PY2 else str
 
@@ -3,6 +3,7 @@
 from __future__ import unicode_literals
 
 from extractor import *
+from extractor import util
 
 #ref = 'AGCTGTGGGAGGGAGCCAGTGGATTTGGAAACAGAAATGGCTTGGCCTTGCCTGCCTGCCTGCCTGCCTTCCTTCCTTCCTTCCTTCCTTCCTTCCTTCCTTCCTTCCTTCCTTCCCTCCTGCAATCCTTTAACTTACTGAATAACTCATGATTATGGGCCACCTGCAGGTACCATGCTAG'
 #alt = 'AGCTGTGGGAGGGAGCCAGTGGATTTGGAAACAGAAATGGCTTCGCCTTGCCTGCCTGCCTGCCTGCCTTCCTTCCTTCCTTCCTTCCTTCCTTCCTTCCTTCCTTCCTTCCTTCCGTCCTTCCTTCCCTCCTGCAATCCTATAACTTACTGAATAACTCATGATTATGGGCCACCTGCAGGTACCATGCTAG'
@@ -15,31 +16,15 @@ from extractor import *
 THRESHOLD = 10000
 
 
-class Repeat(object):
-    """
-    Simple repeat structure.
-    """
-    __slots__ = ['start', 'end', 'count']
-
-    def __init__(self, start, end, count=0):
-        """
-        Initialize the repeat structure.
-
-        :arg integer start: Start position of the repeat.
-        :arg integer end: End position of the repeat.
-        :arg integer count: Number of repeats.
-        """
-        self.start = start
-        self.end = end
-        self.count = count
-
-
 def short_sequence_repeat_extractor(string, min_length=1):
     """
-    Extract the short tandem repeat structure from a string.
+    Extract the short tandem repeat structure from a string. The repeats
+    are found by the extractor module (see `short_tandem_repeats`).
 
     :arg string string: The string.
     :arg integer min_length: Minimum length of the repeat structure.
+
+    :returns: The repeats (`Repeat` objects with start, end and count).
     """
     length = len(string)
 
@@ -47,36 +32,9 @@ def short_sequence_repeat_extractor(string, min_length=1):
     if k_max > THRESHOLD:
         k_max = THRESHOLD // 2
 
-    repeats = []
-
-    i = 0
-    last_repeat = i
-    while i < length:
-        max_count = 0
-        max_k = 1
-        for k in range(min_length, k_max):
-            count = 0
-            for j in range(i + k, length - k + 1, k):
-                if string[i:i + k] != string[j:j + k]:
-                    break
-                count += 1
-
-            if count > 0 and count >= max_count:
-                max_count = count
-                max_k = k
-
-        if max_count > 0:
-            if last_repeat < i:
-                repeats.append(Repeat(last_repeat, i))
-            repeats.append(Repeat(i, i + max_k, max_count))
-            last_repeat = i + max_k * (max_count + 1)
-
-        i += max_k * (max_count + 1)
-
-    if last_repeat < i:
-        repeats.append(Repeat(last_repeat, i))
-
-    return repeats
+    string_swig = util.swig_str(string)
+    return list(short_tandem_repeats(string_swig[0], string_swig[1],
+        min_length, max(k_max - 1, 1)))
 
 
 min_count = 3
@@ -52,7 +52,8 @@ setup(
     name='description-extractor',
     cmdclass=custom_cmdclass,
     ext_modules=[Extension('_extractor', ['extractor/extractor.i',
-        'extractor/extractor.cc'], swig_opts=['-c++'])],
+        'extractor/extractor.cc'], swig_opts=['-c++'],
+        extra_compile_args=['-std=c++17', '-pthread'], extra_link_args=['-pthread'])],
     version=distmeta['__version__'],
     description='HGVS variant description extractor',
     long_description=long_description,
@@ -0,0 +1,12 @@
+"""
+Test configuration: modules using syntax of newer Python versions are not
+collected on older ones.
+"""
+
+
+import sys
+
+
+collect_ignore = []
+if sys.version_info < (3, 5):
+    collect_ignore.append('test_extractor_async.py')
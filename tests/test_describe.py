@@ -6,7 +6,7 @@ Tests for the mutalyzer.describe module.
 from __future__ import (absolute_import, division, print_function,
                         unicode_literals)
 
-from extractor import describe_dna
+from extractor import describe_dna, describe_dna_allele
 from extractor.util import str
 
 
@@ -29,6 +29,7 @@ class TestDescribe:
         assert result[0].deleted[0].sequence == expected[5]
         assert result[0].inserted[0].sequence == expected[6]
         assert str(result[0]) == expected[7]
+        assert describe_dna_allele(reference, sample) == expected[7]
 
 
     def test1(self):
@@ -181,3 +182,19 @@ class TestDescribe:
         """
         self._single_variant('ACGTCGTCTCGCTAGCTTCGGGGGATAGATAGAGATATAGAGAT',
             ('delins', 7, 8, 7, 8, 'AT', 'TC', '7_8delinsTC'))
+
+
+    def test_allele(self):
+        """
+        Test the native allele description.
+        """
+        for reference, sample in (
+                ('ATGATGATCAGATACAGTGTGATACAGGTAGTTAGACAA',
+                 'ATGATTTGATCAGATACATGTGATACCGGTAGTTAGGACAA'),
+                ('TAACAATGGAAC', 'TAAACAATTGAA'),
+                ('ATGATGATCAGATACAGTGTGATACAGGTAGTTAGACAA',
+                 'ATGATGATCAGTCACACTGTATCTGGTAGTTAGACAA'),
+                ('ACGTCGATTCGCTAGCTTCGGGGGATAGATAGAGATATAGAGAT',
+                 'ACGTCGATTCGCTAGCTTCGGGGGATAGATAGAGATATAGAGAT')):
+            assert (describe_dna_allele(reference, sample) ==
+                str(describe_dna(reference, sample)))
@@ -6,6 +6,11 @@ Unit tests for the extractor Python interface.
 from __future__ import (absolute_import, division, print_function,
                         unicode_literals)
 
+import os
+import threading
+
+import pytest
+
 from extractor import extractor, util
 
 
@@ -22,6 +27,15 @@ class TestExtractor:
             for attribute, expected_value in expected_variant.items():
                 assert getattr(variant, attribute) == expected_value
 
+    def _assert_same_variants(self, variants, expected_variants,
+                              attributes=('reference_start', 'reference_end',
+                                          'sample_start', 'sample_end', 'type')):
+        assert len(variants) == len(expected_variants)
+
+        for variant, expected_variant in zip(variants, expected_variants):
+            for attribute in attributes:
+                assert getattr(variant, attribute) == getattr(expected_variant, attribute)
+
     def test1(self):
         self._test_dna(
             'ATGATGATCAGATACAGTGTGATACAGGTAGTTAGACAA',
@@ -590,3 +604,388 @@ class TestExtractor:
               'type': 1,
               'reference_start': 8}]
         )
+
+    def test_batch(self):
+        pairs = [
+            ('ATGATGATCAGATACAGTGTGATACAGGTAGTTAGACAA',
+             'ATGATTTGATCAGATACATGTGATACCGGTAGTTAGGACAA'),
+            ('ACGTCGATTCGCTAGCTTCGGGGGATAGATAGAGATATAGAGAT',
+             'ACGTCGTCTCGCTAGCTTCGGGGGATAGATAGAGATATAGAGAT'),
+            ('ACGT', 'ACGT')] * 4
+
+        batch = extractor.extract_batch(
+            extractor.StringVector([util.swig_str(s1)[0] for s1, _ in pairs]),
+            extractor.StringVector([util.swig_str(s2)[0] for _, s2 in pairs]),
+            extractor.TYPE_DNA, None, 3)
+
+        assert len(batch) == len(pairs)
+
+        for (s1, s2), extracted in zip(pairs, batch):
+            s1_swig = util.swig_str(s1)
+            s2_swig = util.swig_str(s2)
+            single = extractor.extract(s1_swig[0], s1_swig[1],
+                                       s2_swig[0], s2_swig[1], extractor.TYPE_DNA)
+
+            assert extracted.weight_position == single.weight_position
+            self._assert_same_variants(extracted.variants, single.variants,
+                ('reference_start', 'reference_end', 'sample_start', 'sample_end',
+                 'type', 'transposition_start', 'transposition_end'))
+
+    def test_batch_size_mismatch(self):
+        with pytest.raises(ValueError):
+            extractor.extract_batch(
+                extractor.StringVector(['ACGT', 'ACGT']),
+                extractor.StringVector(['ACGT']),
+                extractor.TYPE_DNA, None, 1)
+
+    def test_annotate_on_demand(self):
+        reference = ('MAVLWRLSAVCGALGGRALLLRTPVVRPAHISAFLQDRPIPEWCGVQHIHLSPSHHSGS' +
+                     'KAASLHWTSERVVSVLLLGLLPAAYLNPCSAMDYSLAAALTLHGHWGLGQVVTDYVHGDA' +
+                     'LQKAAKAGLLALSALTFAGLCYFNYHDVGICKAVAMLWKL*')
+        sample = ('MAVLWRLVCGALGGRALLLRTPVVRPAHISAFLQDRPIPEWCGVQHIHLSPSHHSGSKAASL' +
+                  'HWTSERVVSVLLLGLLPAAYLNPCSAMDYSLAAALTFMVTGALDKLLLTMFMGMPCRKLPRQG' +
+                  'FWHFQL*')
+        codons = util.swig_str(util.codon_table_string(1))
+        s1_swig = util.swig_str(reference)
+        s2_swig = util.swig_str(sample)
+
+        annotated = extractor.extract(s1_swig[0], s1_swig[1],
+                                      s2_swig[0], s2_swig[1],
+                                      extractor.TYPE_PROTEIN, codons[0], True)
+        plain = extractor.extract(s1_swig[0], s1_swig[1],
+                                  s2_swig[0], s2_swig[1],
+                                  extractor.TYPE_PROTEIN, codons[0], False)
+
+        assert not any(variant.type & extractor.FRAME_SHIFT
+                       for variant in plain.variants)
+        assert any(variant.type & extractor.FRAME_SHIFT
+                   for variant in annotated.variants)
+
+        merged = []
+        for variant in plain.variants:
+            merged.append(variant)
+            merged.extend(extractor.annotate_frame_shift(
+                s1_swig[0], s1_swig[1], s2_swig[0], s2_swig[1], variant,
+                codons[0]))
+
+        self._assert_same_variants(merged, annotated.variants)
+
+    def test_extract_translated(self):
+        reference = 'ATGGCTGCTAAAGGTTTCTAA'
+        sample = 'ATGGCTGCAAAGGTTTCTAAG'
+        codons = util.swig_str(util.codon_table_string(1))
+        s1_swig = util.swig_str(reference)
+        s2_swig = util.swig_str(sample)
+
+        translated = extractor.extract_translated(s1_swig[0], s1_swig[1],
+                                                  s2_swig[0], s2_swig[1],
+                                                  codons[0])
+
+        assert translated.reference == 'MAAKGF*'
+        assert translated.sample == 'MAAKVSK'
+
+        p1_swig = util.swig_str(translated.reference)
+        p2_swig = util.swig_str(translated.sample)
+        extracted = extractor.extract(p1_swig[0], p1_swig[1],
+                                      p2_swig[0], p2_swig[1],
+                                      extractor.TYPE_PROTEIN, codons[0])
+
+        assert translated.weight_position == extracted.weight_position
+        self._assert_same_variants(translated.variants, extracted.variants)
+
+    def test_annotation_threads(self):
+        # Two frame shifted regions of 200 amino acids: the substitutions
+        # exceed the threshold for a parallel frame shift annotation.
+        state = 1
+        bases = []
+        for _ in range(1800):
+            state = (state * 1103515245 + 12345) % 2 ** 31
+            bases.append('ACGT'[(state >> 16) & 3])
+        reference = ''.join(bases)
+        sample = (reference[:150] + reference[151:750] + 'A' +
+                  reference[750:1050] + reference[1051:1650] + 'C' +
+                  reference[1650:])
+        codons = util.swig_str(util.codon_table_string(1))
+        s1_swig = util.swig_str(reference)
+        s2_swig = util.swig_str(sample)
+
+        single = extractor.extract_translated(s1_swig[0], s1_swig[1],
+                                              s2_swig[0], s2_swig[1],
+                                              codons[0], True, 1)
+        assert sum((variant.reference_end - variant.reference_start) *
+                   (variant.sample_end - variant.sample_start)
+                   for variant in single.variants
+                   if variant.type == extractor.SUBSTITUTION) >= 65536
+        assert any(variant.type & extractor.FRAME_SHIFT
+                   for variant in single.variants)
+
+        for threads in (0, 2, 4):
+            parallel = extractor.extract_translated(s1_swig[0], s1_swig[1],
+                                                    s2_swig[0], s2_swig[1],
+                                                    codons[0], True, threads)
+            self._assert_same_variants(parallel.variants, single.variants)
+
+        p1_swig = util.swig_str(single.reference)
+        p2_swig = util.swig_str(single.sample)
+        parallel = extractor.extract(p1_swig[0], p1_swig[1],
+                                     p2_swig[0], p2_swig[1],
+                                     extractor.TYPE_PROTEIN, codons[0], True, 4)
+        self._assert_same_variants(parallel.variants, single.variants)
+
+    def test_threads(self):
+        pairs = [
+            ('ATGATGATCAGATACAGTGTGATACAGGTAGTTAGACAA',
+             'ATGATTTGATCAGATACATGTGATACCGGTAGTTAGGACAA'),
+            ('ACGTCGATTCGCTAGCTTCGGGGGATAGATAGAGATATAGAGAT',
+             'ACGTCGTCTCGCTAGCTTCGGGGGATAGATAGAGATATAGAGAT')] * 8
+
+        def extract(s1, s2):
+            s1_swig = util.swig_str(s1)
+            s2_swig = util.swig_str(s2)
+            return extractor.extract(s1_swig[0], s1_swig[1],
+                                     s2_swig[0], s2_swig[1], extractor.TYPE_DNA)
+
+        results = [None] * len(pairs)
+
+        def worker(index):
+            results[index] = extract(*pairs[index])
+
+        threads = [threading.Thread(target=worker, args=(index,))
+                   for index in range(len(pairs))]
+        for thread in threads:
+            thread.start()
+        for thread in threads:
+            thread.join()
+
+        for (s1, s2), extracted in zip(pairs, results):
+            single = extract(s1, s2)
+            assert extracted.weight_position == single.weight_position
+            self._assert_same_variants(extracted.variants, single.variants)
+
+    def test_buffer(self):
+        s1 = 'ATGATGATCAGATACAGTGTGATACAGGTAGTTAGACAA'
+        s2 = 'ATGATTTGATCAGATACATGTGATACCGGTAGTTAGGACAA'
+        s1_swig = util.swig_str(s1)
+        s2_swig = util.swig_str(s2)
+        expected = extractor.extract(s1_swig[0], s1_swig[1],
+                                     s2_swig[0], s2_swig[1], extractor.TYPE_DNA)
+
+        for convert in (bytes, bytearray, lambda s: memoryview(bytes(s))):
+            b1_swig = util.swig_str(convert(s1.encode('ascii')))
+            b2_swig = util.swig_str(convert(s2.encode('ascii')))
+            extracted = extractor.extract(b1_swig[0], b1_swig[1],
+                                          b2_swig[0], b2_swig[1], extractor.TYPE_DNA)
+
+            self._assert_same_variants(extracted.variants, expected.variants)
+
+    def test_buffer_non_contiguous(self):
+        if util.PY2:
+            return
+        s = memoryview(b'ATGATGATCAGATACAGTGTGATACAGGTAGTTAGACAA')[::2]
+        with pytest.raises(ValueError):
+            extractor.extract(s, len(s), s, len(s), extractor.TYPE_DNA)
+
+    def test_buffer_length(self):
+        s = b'ATGATGATCAGATACAGTGTGATACAGGTAGTTAGACAA'
+        with pytest.raises(ValueError):
+            extractor.extract(s, len(s) + 1, s, len(s), extractor.TYPE_DNA)
+        with pytest.raises(ValueError):
+            extractor.extract(s, len(s), 'ATGATG', 7, extractor.TYPE_DNA)
+        with pytest.raises(ValueError):
+            extractor.short_tandem_repeats(bytearray(s), len(s) + 1)
+
+    def test_variants_out_of_range(self):
+        s1 = 'ATGATGATCAGATACAGTGTGATACAGGTAGTTAGACAA'
+        s2 = 'ATGATTTGATCAGATACATGTGATACCGGTAGTTAGGACAA'
+        s1_swig = util.swig_str(s1)
+        s2_swig = util.swig_str(s2)
+        extracted = extractor.extract(s1_swig[0], s1_swig[1],
+                                      s2_swig[0], s2_swig[1], extractor.TYPE_DNA)
+
+        with pytest.raises(IndexError):
+            extractor.describe_dna_allele(s1_swig[0], s1_swig[1],
+                                          s2_swig[0][:10], 10, extracted.variants)
+        with pytest.raises(IndexError):
+            extractor.split_masked_variants(s2_swig[0][:10], 10,
+                                            extracted.variants, 0)
+
+    def test_variants_buffer(self):
+        s1 = 'ATGATGATCAGATACAGTGTGATACAGGTAGTTAGACAA'
+        s2 = 'ATGATTTGATCAGATACATGTGATACCGGTAGTTAGGACAA'
+        s1_swig = util.swig_str(s1)
+        s2_swig = util.swig_str(s2)
+        extracted = extractor.extract(s1_swig[0], s1_swig[1],
+                                      s2_swig[0], s2_swig[1], extractor.TYPE_DNA)
+
+        buffer = extracted.variants_buffer()
+        assert len(buffer) == len(extracted.variants) * extractor.VARIANT_RECORD_FIELDS * 8
+
+        records = list(util.variant_records(extracted))
+        assert len(records) == len(extracted.variants)
+        for record, variant in zip(records, extracted.variants):
+            for attribute in ('reference_start', 'reference_end',
+                              'sample_start', 'sample_end', 'type',
+                              'transposition_start', 'transposition_end',
+                              'shift5', 'shift3', 'palindrome'):
+                assert getattr(record, attribute) == getattr(variant, attribute)
+
+    def test_variants_array(self):
+        pytest.importorskip('numpy')
+        s1 = 'ATGATGATCAGATACAGTGTGATACAGGTAGTTAGACAA'
+        s2 = 'ATGATTTGATCAGATACATGTGATACCGGTAGTTAGGACAA'
+        s1_swig = util.swig_str(s1)
+        s2_swig = util.swig_str(s2)
+        extracted = extractor.extract(s1_swig[0], s1_swig[1],
+                                      s2_swig[0], s2_swig[1], extractor.TYPE_DNA)
+
+        array = util.variants_array(extracted)
+        assert len(array) == len(extracted.variants)
+        for record, variant in zip(array, extracted.variants):
+            assert record['reference_start'] == variant.reference_start
+            assert record['sample_end'] == variant.sample_end
+            assert record['type'] == variant.type
+
+    def test_shift(self):
+        self._test_dna('ATGATGATCAGATACAGTGTGATACAGGTAGTTAGACAA',
+                       'ATGATCAGATACAGTGTGTGATACAGGTAGTTAGACAA', [
+            {'reference_start': 0, 'reference_end': 5, 'sample_start': 0, 'sample_end': 5, 'shift5': 0, 'shift3': 0},
+            {'reference_start': 5, 'reference_end': 8, 'sample_start': 5, 'sample_end': 5, 'shift5': 5, 'shift3': 0},
+            {'reference_start': 8, 'reference_end': 16, 'sample_start': 5, 'sample_end': 13, 'shift5': 0, 'shift3': 0},
+            {'reference_start': 16, 'reference_end': 16, 'sample_start': 13, 'sample_end': 15, 'shift5': 0, 'shift3': 5},
+            {'reference_start': 16, 'reference_end': 39, 'sample_start': 15, 'sample_end': 38, 'shift5': 0, 'shift3': 0}])
+
+    def test_group_protein_variants(self):
+        reference = ('MAVLWRLSAVCGALGGRALLLRTPVVRPAHISAFLQDRPIPEWCGVQHIHLSPSHHSGS' +
+                     'KAASLHWTSERVVSVLLLGLLPAAYLNPCSAMDYSLAAALTLHGHWGLGQVVTDYVHGDA' +
+                     'LQKAAKAGLLALSALTFAGLCYFNYHDVGICKAVAMLWKL*')
+        sample = ('MAVLWRLVCGALGGRALLLRTPVVRPAHISAFLQDRPIPEWCGVQHIHLSPSHHSGSKAASL' +
+                  'HWTSERVVSVLLLGLLPAAYLNPCSAMDYSLAAALTFMVTGALDKLLLTMFMGMPCRKLPRQG' +
+                  'FWHFQL*')
+        codons = util.swig_str(util.codon_table_string(1))
+        s1_swig = util.swig_str(reference)
+        s2_swig = util.swig_str(sample)
+        extracted = extractor.extract(s1_swig[0], s1_swig[1],
+                                      s2_swig[0], s2_swig[1],
+                                      extractor.TYPE_PROTEIN, codons[0])
+
+        grouped = extractor.group_protein_variants(extracted.variants)
+        assert [(protein_variant.variant.reference_start,
+                 protein_variant.variant.reference_end,
+                 protein_variant.variant.sample_start,
+                 protein_variant.variant.sample_end)
+                for protein_variant in grouped] == [(7, 9, 7, 7), (100, 158, 98, 130)]
+        assert len(grouped[0].segments) == 0
+        assert [(segment.reference_start, segment.reference_end,
+                 segment.sample_start, segment.sample_end, list(segment.frames))
+                for segment in grouped[1].segments] == [(100, 132, 98, 130, ['2'])]
+
+    def test_mask_repeats(self):
+        masked = extractor.mask_repeats('CAGCAGCAGTTATTACAGCAG', 21,
+                                        extractor.StringVector(['CAG', 'TTA']))
+        assert masked.string == '$' * 21
+        assert [(repeat.start, repeat.count, repeat.unit)
+                for repeat in masked.repeats] == [(0, 3, 0), (9, 2, 1), (15, 2, 0)]
+
+    def test_copied_arguments(self):
+        # The containers are copied (proxies) or converted (sequences)
+        # before the GIL is released; the proxies are left unchanged.
+        unit = extractor.StringVector(['CAG', 'TTA'])
+        masked = extractor.mask_repeats('CAGCAGCAGTTATTACAGCAG', 21, unit)
+        converted = extractor.mask_repeats('CAGCAGCAGTTATTACAGCAG', 21,
+                                           ['CAG', 'TTA'])
+        assert list(unit) == ['CAG', 'TTA']
+        assert masked.string == converted.string
+        assert [(repeat.start, repeat.count, repeat.unit)
+                for repeat in masked.repeats] == [(repeat.start, repeat.count, repeat.unit)
+                                                  for repeat in converted.repeats]
+
+        s1_swig = util.swig_str('TAACAATGGAAC')
+        s2_swig = util.swig_str('TAAACAATTGAA')
+        extracted = extractor.extract(s1_swig[0], s1_swig[1],
+                                      s2_swig[0], s2_swig[1], extractor.TYPE_DNA)
+        variants = extracted.variants
+        assert extractor.describe_dna_allele(s1_swig[0], s1_swig[1],
+                                             s2_swig[0], s2_swig[1],
+                                             variants) == '[3dup;8G>T;12del]'
+        assert extractor.describe_dna_allele(s1_swig[0], s1_swig[1],
+                                             s2_swig[0], s2_swig[1],
+                                             list(variants)) == '[3dup;8G>T;12del]'
+        assert len(variants) == 6
+
+    def test_split_masked_variants(self):
+        s1 = 'ACGTTTGCA'
+        s2 = 'ACGA$$CCTGCA'
+        s1_swig = util.swig_str(s1)
+        s2_swig = util.swig_str(s2)
+        extracted = extractor.extract(s1_swig[0], s1_swig[1],
+                                      s2_swig[0], s2_swig[1], extractor.TYPE_DNA)
+
+        split = extractor.split_masked_variants(s2_swig[0], s2_swig[1],
+                                                extracted.variants, 3)
+        assert [(variant.reference_start, variant.reference_end,
+                 variant.sample_start, variant.sample_end)
+                for variant in split] == [(0, 3, 0, 3), (6, 8, 3, 4),
+                                          (6, 8, 6, 8), (5, 9, 8, 12)]
+
+    def test_short_tandem_repeats(self):
+        s = 'ACAGCAGCAGTTTTGATA'
+        repeats = extractor.short_tandem_repeats(s, len(s))
+        assert [(repeat.start, repeat.end, repeat.count)
+                for repeat in repeats] == [(0, 1, 0), (1, 4, 2), (10, 11, 3), (14, 18, 0)]
+
+        repeats = extractor.short_tandem_repeats(s, len(s), 3)
+        assert [(repeat.start, repeat.end, repeat.count)
+                for repeat in repeats] == [(0, 1, 0), (1, 4, 2), (10, 18, 0)]
+
+    def test_extract_async(self):
+        pairs = [('ATGATGATCAGATACAGTGTGATACAGGTAGTTAGACAA',
+                  'ATGATTTGATCAGATACATGTGATACCGGTAGTTAGGACAA'),
+                 ('TAACAATGGAAC', 'TAAACAATTGAA')] * 16
+        identifiers = []
+        for s1, s2 in pairs:
+            s1_swig = util.swig_str(s1)
+            s2_swig = util.swig_str(s2)
+            identifiers.append(extractor.extract_async(s1_swig[0], s1_swig[1],
+                                                       s2_swig[0], s2_swig[1], extractor.TYPE_DNA))
+
+        for identifier, (s1, s2) in zip(identifiers, pairs):
+            extracted = extractor.extraction_result(identifier)
+            assert not extractor.extraction_done(identifier)
+            s1_swig = util.swig_str(s1)
+            s2_swig = util.swig_str(s2)
+            expected = extractor.extract(s1_swig[0], s1_swig[1],
+                                         s2_swig[0], s2_swig[1], extractor.TYPE_DNA)
+            assert extracted.weight_position == expected.weight_position
+            self._assert_same_variants(extracted.variants, expected.variants)
+
+        assert len(extractor.completed_extractions()) == 0
+
+    def test_extraction_result_taken(self):
+        s1_swig = util.swig_str('TAACAATGGAAC')
+        s2_swig = util.swig_str('TAAACAATTGAA')
+        identifier = extractor.extract_async(s1_swig[0], s1_swig[1],
+                                             s2_swig[0], s2_swig[1], extractor.TYPE_DNA)
+
+        assert len(extractor.extraction_result(identifier).variants) == 6
+        with pytest.raises(KeyError):
+            extractor.extraction_result(identifier)
+        with pytest.raises(KeyError):
+            extractor.extraction_result(identifier + 1000)
+
+    def test_extract_async_fork(self):
+        if not hasattr(os, 'fork'):
+            return
+        s1_swig = util.swig_str('TAACAATGGAAC')
+        s2_swig = util.swig_str('TAAACAATTGAA')
+        identifier = extractor.extract_async(s1_swig[0], s1_swig[1],
+                                             s2_swig[0], s2_swig[1], extractor.TYPE_DNA)
+
+        pid = os.fork()
+        if pid == 0:
+            child = extractor.extract_async(s1_swig[0], s1_swig[1],
+                                            s2_swig[0], s2_swig[1], extractor.TYPE_DNA)
+            os._exit(0 if len(extractor.extraction_result(child).variants) == 6 else 1)
+
+        _, status = os.waitpid(pid, 0)
+        assert status == 0
+        assert len(extractor.extraction_result(identifier).variants) == 6
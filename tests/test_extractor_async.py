@@ -0,0 +1,32 @@
+"""
+Unit tests for the asyncio interface of the extractor (Python 3.5 and
+higher only, see conftest.py).
+"""
+
+
+from __future__ import (absolute_import, division, print_function,
+                        unicode_literals)
+
+import asyncio
+
+from extractor import describe
+
+
+class TestExtractorAsync:
+    def test_extract_async_future(self):
+        s1 = 'TAACAATGGAAC'
+        s2 = 'TAAACAATTGAA'
+
+        async def extract():
+            return await asyncio.gather(*[describe.extract_async(s1, s2)
+                                          for _ in range(8)])
+
+        loop = asyncio.new_event_loop()
+        try:
+            results = loop.run_until_complete(extract())
+        finally:
+            loop.close()
+
+        for extracted in results:
+            assert [(variant.reference_start, variant.reference_end)
+                    for variant in extracted.variants] == [(0, 3), (3, 3), (3, 7), (7, 8), (8, 11), (11, 12)]